@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "asyncIO.h"
+
+// RLE pair format: [count][character], runs capped at 255
+std::vector<uint8_t> rle_compress_sequential(const uint8_t* input, size_t size);
+std::vector<uint8_t> rle_compress_sequential(const std::vector<uint8_t>& input);
+std::vector<uint8_t> rle_compress_parallel(const std::vector<uint8_t>& input, 
+                                           int num_threads = 4);
+
+std::vector<uint8_t> rle_decompress_sequential(const std::vector<uint8_t>& input);
+std::vector<uint8_t> rle_decompress_parallel(const std::vector<uint8_t>& input, 
+                                             int num_threads = 4);
+
+/**
+ * Pipeline structure for producer-consumer pattern
+ * Stage 1: Read data (I/O)       - AsyncFileReader, queue_depth reads in flight
+ * Stage 2: Compress (Compute)    - this thread, one chunk at a time
+ * Stage 3: Write data (I/O)      - AsyncFileWriter, queue_depth writes in flight
+ * Reads and writes are serviced by io_uring (or the thread fallback) while
+ * the codec works on the current chunk, so storage latency overlaps compute.
+ */
+class CompressionPipeline {
+private:
+    int queue_depth;
+    AsyncBackend backend;
+    
+public:
+    CompressionPipeline(int num_buffers = 4, AsyncBackend io_backend = AsyncBackend::Auto) 
+        : queue_depth(num_buffers), backend(io_backend) {}
+    
+    /**
+     * Pipeline compression with I/O and compute running concurrently.
+     * Every chunk is compressed independently; RLE pairs are self-delimiting
+     * so the concatenated output, behind a pair8 stream header, is a single
+     * stream rle_decode_stream() accepts. The input must be a regular file.
+     */
+    bool compress_pipeline(const std::string& input_file, 
+                          const std::string& output_file,
+                          size_t chunk_size = 1024 * 1024);
+};
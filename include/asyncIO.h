@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// I/O engine behind AsyncFileReader / AsyncFileWriter.
+// Auto picks io_uring when the kernel supports it and falls back to a
+// background I/O thread otherwise.
+enum class AsyncBackend { Auto, IoUring, Threads };
+
+const char* asyncBackendName(AsyncBackend backend);
+
+/**
+ * Sequential file reader that keeps queueDepth chunk reads in flight.
+ * Chunks are handed out in file order; the pointer returned by next()
+ * stays valid until the following call to next().
+ */
+class AsyncFileReader {
+public:
+    AsyncFileReader(const std::string& path, size_t chunkSize = 1024 * 1024,
+                    int queueDepth = 4, AsyncBackend backend = AsyncBackend::Auto);
+    ~AsyncFileReader();
+
+    bool isOpen() const;
+    // 0 for pipes and other inputs without a size; those are read until EOF
+    uint64_t fileSize() const;
+    bool sizeKnown() const;
+    AsyncBackend backend() const;
+
+    // Returns the next chunk, or nullptr (size 0) at end of file / on error
+    const uint8_t* next(size_t& size);
+    bool failed() const;
+
+    struct Impl;
+private:
+    std::unique_ptr<Impl> impl;
+};
+
+/**
+ * Appending file writer with queueDepth chunk writes in flight.
+ * write() copies into one of the (registered) chunk buffers and only
+ * blocks when every buffer is still waiting on the device.
+ */
+class AsyncFileWriter {
+public:
+    AsyncFileWriter(const std::string& path, size_t chunkSize = 1024 * 1024,
+                    int queueDepth = 4, AsyncBackend backend = AsyncBackend::Auto);
+    ~AsyncFileWriter();
+
+    bool isOpen() const;
+    AsyncBackend backend() const;
+
+    bool write(const void* data, size_t size);
+    // Flushes the partial buffer and waits for all outstanding writes
+    bool close();
+
+    struct Impl;
+private:
+    std::unique_ptr<Impl> impl;
+};
+
+// Reads a whole file through AsyncFileReader. Returns false if it can't be opened.
+bool readFileAsync(const std::string& path, std::string& contents,
+                   AsyncBackend backend = AsyncBackend::Auto);
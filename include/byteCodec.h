@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// BYTE-LEVEL SERIALISATION
+// ============================================================================
+//
+// Little-endian fixed-width values and LEB128 varints, shared by the RLE
+// stream formats (rleFormats.h) and the dedup container (dedup.h).
+
+namespace byte_codec {
+
+// Values are serialised little-endian regardless of the host
+template <typename T>
+inline T load(const uint8_t* p) {
+    T v = 0;
+    for (size_t i = 0; i < sizeof(T); i++) v |= static_cast<T>(static_cast<T>(p[i]) << (8 * i));
+    return v;
+}
+
+template <typename T>
+inline void store(uint8_t* p, T v) {
+    for (size_t i = 0; i < sizeof(T); i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+template <typename T>
+inline void append(std::vector<uint8_t>& out, T v) {
+    for (size_t i = 0; i < sizeof(T); i++) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+// Unsigned LEB128: seven bits per byte, high bit set on all but the last
+inline void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+// Advances p past the varint; false if it runs off end or past 64 bits
+inline bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+} // namespace byte_codec
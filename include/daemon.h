@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct DaemonOptions {
+    std::string socketPath;
+    int workers = 0;                    // 0 = one per hardware thread
+    size_t batchSize = 16;              // most requests a worker takes per wake-up
+    size_t bufferBytes = 1024 * 1024;   // preallocated I/O buffers per worker
+    size_t cacheEntries = 1024;         // Huffman tables kept by histogram, decoders by map
+};
+
+/**
+ * Serves compress/decompress requests on a Unix domain socket with a warm
+ * worker pool until a client sends "shutdown" (or SIGINT/SIGTERM).
+ * Returns the process exit code.
+ */
+int runDaemon(const DaemonOptions& options);
+
+/**
+ * Thin client: args is one request in CLI form (compress <in> <out>
+ * [--words|--bigrams|--dedup], decompress <in> <out>, stats, shutdown), or "-" to
+ * send one request per stdin line in a single batch. Requests in a batch run in
+ * order, each seeing the files written by the ones before it; stats and shutdown
+ * wait for them too. Prints replies in order.
+ */
+int runClient(const std::string& socketPath, const std::vector<std::string>& args);
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// ============================================================================
+// CONTENT-DEFINED CHUNKING AND DEDUPLICATION
+// ============================================================================
+//
+// Optional stage in front of a codec. Input is cut into chunks where a Gear
+// rolling hash hits a mask (FastCDC-style normalised chunking), so an insert
+// only moves the boundaries next to it. Each chunk is fingerprinted; repeats
+// become references to the first copy and only the unique chunks,
+// concatenated, are handed to the codec.
+//
+// Stream layout: "DDP", version, original size (u64 LE), chunk count and
+// unique count (LEB128), the unique chunk lengths (LEB128), one unique index
+// per chunk (LEB128), then the codec payload.
+
+struct DedupParams {
+    size_t minChunk = 2 * 1024;
+    size_t avgChunk = 8 * 1024;     // rounded down to a power of two
+    size_t maxChunk = 64 * 1024;
+    int threads = 0;                // fingerprinting: 0 = all available, 1 = serial
+};
+
+struct DedupStats {
+    size_t chunks = 0;
+    size_t uniqueChunks = 0;
+    size_t uniqueBytes = 0;
+    size_t duplicateBytes = 0;
+};
+
+const size_t DEDUP_HEADER_SIZE = 12;
+
+// Encodes the unique bytes; the result is stored as the stream payload
+using DedupEncoder = std::function<std::vector<uint8_t>(const uint8_t* data, size_t size)>;
+
+// Decodes a payload back into the unique bytes. Producing more than
+// expectedSize bytes is allowed (e.g. Huffman padding); the tail is dropped.
+using DedupDecoder = std::function<bool(const uint8_t* payload, size_t size,
+                                        size_t expectedSize, std::vector<uint8_t>& out)>;
+
+// Chunk end offsets for data; the last one is always size
+std::vector<size_t> dedup_chunk_boundaries(const uint8_t* data, size_t size,
+                                           const DedupParams& params = DedupParams());
+
+std::vector<uint8_t> dedup_encode_stream(const uint8_t* input, size_t size, const DedupEncoder& encode,
+                                         const DedupParams& params = DedupParams(),
+                                         DedupStats* stats = nullptr);
+
+// Returns false on a bad header, a corrupt chunk table or a failed decode
+bool dedup_decode_stream(const uint8_t* input, size_t size, const DedupDecoder& decode,
+                         std::vector<uint8_t>& output);
+
+bool dedup_is_stream(const uint8_t* input, size_t size);
@@ -1,4 +1,30 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <string>
+#include <vector>
 
-void compress(const std::string& inputFile,const std::string& outputFile);
+struct DedupStats;
+
+// numThreads: 0 = all available, 1 = serial. Parallel output is byte-identical.
+bool compress(const std::string& inputFile,const std::string& outputFile,int numThreads = 0);
+
+// Same codec behind the content-defined dedup stage (dedup.h): repeated
+// chunks are stored as references and only unique bytes are Huffman coded.
+// The map file starts with HUFFMAN_DEDUP_MAGIC so decompress() can tell.
+bool compressDedup(const std::string& inputFile,const std::string& outputFile,int numThreads = 0);
+const char* const HUFFMAN_DEDUP_MAGIC = "#huffman-dedup";
+
+// In-memory building blocks behind compress(), also used by the daemon
+std::map<char,std::string> huffmanCode(const std::map<char,int>& freq);
+// Packs text MSB-first into out (resized to fit); returns the number of code bits
+size_t encodeHuffman(const std::string& text,const std::map<char,std::string>& codes,
+                     int numThreads,std::vector<char>& out);
+// header, if given, is written as the first line
+bool writeCodeMap(const std::string& mapFile,const std::map<char,std::string>& codes,
+                  const char* header = nullptr);
+// The stream compressDedup() writes; codes receives the table for the unique bytes.
+// numThreads caps every parallel stage (0 = all available).
+std::vector<uint8_t> encodeDedup(const std::string& text,int numThreads,std::map<char,std::string>& codes,
+                                 size_t* compressedBits = nullptr,DedupStats* stats = nullptr);
@@ -1,4 +1,18 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
-void decompress(const std::string& input,const std::string& output);
\ No newline at end of file
+// Handles every map format: byte codes, --dedup and --words/--bigrams
+bool decompress(const std::string& input,const std::string& output);
+
+// In-memory building blocks behind decompress(), also used by the daemon.
+// A decoder holds the tables parsed from one map file and can be reused for
+// every stream written with that map. nullptr if the map is malformed.
+struct HuffmanDecoder;
+std::shared_ptr<const HuffmanDecoder> loadDecoder(const std::string& mapText);
+// Decodes one compressed file's contents into output
+bool decodeBuffer(const HuffmanDecoder& decoder,const uint8_t* data,size_t size,
+                  std::vector<uint8_t>& output);
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Multi-byte symbol alphabets for text-heavy inputs. Every byte value stays
+// in the alphabet as an escape, so any input round-trips.
+enum class TokenMode { Bigrams, Words };
+
+// First word of a map file written by compressTokens()
+const char* const HUFFMAN_TOKENS_MAGIC = "#huffman-tokens";
+
+bool compressTokens(const std::string& inputFile, const std::string& outputFile, TokenMode mode);
+
+struct TokenStats {
+    size_t symbols = 0;
+    size_t tokens = 0;          // dictionary entries beyond the byte escapes
+    size_t codes = 0;           // symbols that made it into the map
+    uint64_t compressedBits = 0;
+};
+
+// In-memory halves of the token codec, also used by decompress() and the
+// daemon. encodeTokens packs text into out and the map file into mapText.
+TokenStats encodeTokens(const std::string& text, TokenMode mode,
+                        std::vector<char>& out, std::string& mapText);
+
+// Decode tables parsed from a token map, reusable for every stream coded
+// with it. nullptr (with a message on cerr) if the map is malformed.
+struct TokenDecoder;
+std::shared_ptr<const TokenDecoder> loadTokenDecoder(const std::string& mapText);
+bool decodeTokens(const TokenDecoder& decoder, const uint8_t* data, size_t size,
+                  std::vector<uint8_t>& output);
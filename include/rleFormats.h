@@ -0,0 +1,274 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "byteCodec.h"
+#include "simdKernels.h"
+
+// ============================================================================
+// RLE STREAM FORMAT VARIANTS
+// ============================================================================
+//
+// Every variant is a compile-time combination of an element width and a
+// packet layout, so each encode/decode kernel is its own instantiation with
+// no format branches in the inner loop. A stream starts with a 12-byte
+// header: "RLE", the variant id, then the original size in bytes (u64 LE).
+// Bytes left over when the size isn't a multiple of the element width are
+// stored raw after the packets.
+
+enum class RleVariant : uint8_t {
+    Pair8 = 0,          // [count u8][value u8]  (legacy format, runs <= 255)
+    PairCount16 = 1,    // [count u16 LE][value u8]
+    PairVarint = 2,     // [count LEB128][value u8]
+    PairVarint16 = 3,   // [count LEB128][value u16 LE]
+    PairVarint32 = 4,   // [count LEB128][value u32 LE]
+    PackBits8 = 5,      // PackBits literal/run packets over bytes
+    PackBits16 = 6,     // PackBits packets over u16 elements
+    PackBits32 = 7,     // PackBits packets over u32 elements
+};
+
+const size_t RLE_HEADER_SIZE = 12;
+const int RLE_VARIANT_COUNT = 8;
+
+const char* rle_variant_name(RleVariant variant);
+
+// Encodes input as a self-describing stream in the given variant
+std::vector<uint8_t> rle_encode_stream(RleVariant variant, const uint8_t* input, size_t size);
+
+// Decodes any variant, picking the kernel from the stream header.
+// Returns false on a bad header or a truncated/corrupt stream.
+bool rle_decode_stream(const uint8_t* input, size_t size, std::vector<uint8_t>& output);
+
+namespace rle {
+
+// Elements are serialised little-endian regardless of the host
+using byte_codec::load;
+using byte_codec::store;
+using byte_codec::append;
+
+// The 12-byte stream header for a payload that decodes to size bytes
+inline std::vector<uint8_t> header(RleVariant variant, uint64_t size) {
+    std::vector<uint8_t> out = {'R', 'L', 'E', static_cast<uint8_t>(variant)};
+    append<uint64_t>(out, size);
+    return out;
+}
+
+template <typename Elem>
+inline void append_run(std::vector<uint8_t>& out, Elem v, size_t count) {
+    size_t at = out.size();
+    out.resize(at + count * sizeof(Elem));
+    if constexpr (sizeof(Elem) == 1) {
+        memset(out.data() + at, v, count);
+    } else {
+        for (size_t j = 0; j < count; j++) store<Elem>(out.data() + at + j * sizeof(Elem), v);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Count encodings for pair formats
+// ---------------------------------------------------------------------------
+
+struct Count8 {
+    static constexpr uint64_t max_run = 0xFF;
+    static void put(std::vector<uint8_t>& out, uint64_t count) {
+        out.push_back(static_cast<uint8_t>(count));
+    }
+    static bool get(const uint8_t*& p, const uint8_t* end, uint64_t& count) {
+        if (p >= end) return false;
+        count = *p++;
+        return true;
+    }
+};
+
+struct Count16 {
+    static constexpr uint64_t max_run = 0xFFFF;
+    static void put(std::vector<uint8_t>& out, uint64_t count) {
+        append<uint16_t>(out, static_cast<uint16_t>(count));
+    }
+    static bool get(const uint8_t*& p, const uint8_t* end, uint64_t& count) {
+        if (end - p < 2) return false;
+        count = load<uint16_t>(p);
+        p += 2;
+        return true;
+    }
+};
+
+struct CountVarint {
+    static constexpr uint64_t max_run = UINT64_MAX;
+    static void put(std::vector<uint8_t>& out, uint64_t count) {
+        byte_codec::put_varint(out, count);
+    }
+    static bool get(const uint8_t*& p, const uint8_t* end, uint64_t& count) {
+        return byte_codec::get_varint(p, end, count);
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Packet layouts
+// ---------------------------------------------------------------------------
+
+/**
+ * [count][value] pairs. Runs longer than Count::max_run are split.
+ */
+template <typename Elem, typename Count>
+struct PairFormat {
+    static void encode(const uint8_t* in, size_t n, std::vector<uint8_t>& out) {
+        size_t i = 0;
+        while (i < n) {
+            Elem current = load<Elem>(in + i * sizeof(Elem));
+            uint64_t count = 1;
+            if constexpr (sizeof(Elem) == 1) {
+                count = kernels().runLength(in + i, n - i, static_cast<size_t>(Count::max_run));
+            } else {
+                while (i + count < n && count < Count::max_run &&
+                       load<Elem>(in + (i + count) * sizeof(Elem)) == current) {
+                    count++;
+                }
+            }
+            Count::put(out, count);
+            append<Elem>(out, current);
+            i += count;
+        }
+    }
+
+    // Appends n elements to out, one packet at a time
+    static bool decode(const uint8_t*& p, const uint8_t* end, std::vector<uint8_t>& out, size_t n) {
+        size_t produced = 0;
+        while (produced < n) {
+            uint64_t count;
+            if (!Count::get(p, end, count)) return false;
+            if (count == 0 || count > n - produced) return false;
+            if (static_cast<size_t>(end - p) < sizeof(Elem)) return false;
+            append_run<Elem>(out, load<Elem>(p), static_cast<size_t>(count));
+            p += sizeof(Elem);
+            produced += static_cast<size_t>(count);
+        }
+        return true;
+    }
+};
+
+/**
+ * PackBits packets: control byte c < 128 is followed by c+1 literal
+ * elements, c > 128 repeats the next element 257-c times, 128 is a no-op.
+ * Runs shorter than min_run stay inside literal packets.
+ */
+template <typename Elem>
+struct PackBitsFormat {
+    static constexpr size_t max_packet = 128;
+    // A 2-run only pays off once an element is wider than the control byte
+    static constexpr size_t min_run = sizeof(Elem) == 1 ? 3 : 2;
+
+    static size_t run_length(const uint8_t* in, size_t i, size_t n) {
+        if constexpr (sizeof(Elem) == 1) return kernels().runLength(in + i, n - i, max_packet);
+        Elem current = load<Elem>(in + i * sizeof(Elem));
+        size_t run = 1;
+        while (i + run < n && run < max_packet &&
+               load<Elem>(in + (i + run) * sizeof(Elem)) == current) {
+            run++;
+        }
+        return run;
+    }
+
+    static void encode(const uint8_t* in, size_t n, std::vector<uint8_t>& out) {
+        size_t i = 0;
+        while (i < n) {
+            size_t run = run_length(in, i, n);
+            if (run >= min_run) {
+                out.push_back(static_cast<uint8_t>(257 - run));
+                append<Elem>(out, load<Elem>(in + i * sizeof(Elem)));
+                i += run;
+                continue;
+            }
+            size_t start = i;
+            while (i < n && i - start < max_packet) {
+                if (i + min_run <= n && run_length(in, i, i + min_run) >= min_run) break;
+                i++;
+            }
+            out.push_back(static_cast<uint8_t>(i - start - 1));
+            out.insert(out.end(), in + start * sizeof(Elem), in + i * sizeof(Elem));
+        }
+    }
+
+    // Appends n elements to out, one packet at a time
+    static bool decode(const uint8_t*& p, const uint8_t* end, std::vector<uint8_t>& out, size_t n) {
+        size_t produced = 0;
+        while (produced < n) {
+            if (p >= end) return false;
+            uint8_t control = *p++;
+            if (control < 128) {
+                size_t count = static_cast<size_t>(control) + 1;
+                size_t bytes = count * sizeof(Elem);
+                if (count > n - produced || static_cast<size_t>(end - p) < bytes) return false;
+                out.insert(out.end(), p, p + bytes);
+                p += bytes;
+                produced += count;
+            } else if (control > 128) {
+                size_t count = 257 - static_cast<size_t>(control);
+                if (count > n - produced || static_cast<size_t>(end - p) < sizeof(Elem)) return false;
+                append_run<Elem>(out, load<Elem>(p), count);
+                p += sizeof(Elem);
+                produced += count;
+            }
+        }
+        return true;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Variant id -> format type
+// ---------------------------------------------------------------------------
+
+template <RleVariant V> struct FormatOf;
+template <> struct FormatOf<RleVariant::Pair8>        { using type = PairFormat<uint8_t, Count8>; };
+template <> struct FormatOf<RleVariant::PairCount16>  { using type = PairFormat<uint8_t, Count16>; };
+template <> struct FormatOf<RleVariant::PairVarint>   { using type = PairFormat<uint8_t, CountVarint>; };
+template <> struct FormatOf<RleVariant::PairVarint16> { using type = PairFormat<uint16_t, CountVarint>; };
+template <> struct FormatOf<RleVariant::PairVarint32> { using type = PairFormat<uint32_t, CountVarint>; };
+template <> struct FormatOf<RleVariant::PackBits8>    { using type = PackBitsFormat<uint8_t>; };
+template <> struct FormatOf<RleVariant::PackBits16>   { using type = PackBitsFormat<uint16_t>; };
+template <> struct FormatOf<RleVariant::PackBits32>   { using type = PackBitsFormat<uint32_t>; };
+
+template <typename Elem, typename Count>
+constexpr size_t elem_width(PairFormat<Elem, Count>*) { return sizeof(Elem); }
+template <typename Elem>
+constexpr size_t elem_width(PackBitsFormat<Elem>*) { return sizeof(Elem); }
+
+/**
+ * Encodes with a variant fixed at compile time (header included)
+ */
+template <RleVariant V>
+std::vector<uint8_t> encode(const uint8_t* input, size_t size) {
+    using Format = typename FormatOf<V>::type;
+    constexpr size_t width = elem_width(static_cast<Format*>(nullptr));
+
+    std::vector<uint8_t> output = header(V, size);
+    Format::encode(input, size / width, output);
+    output.insert(output.end(), input + size - size % width, input + size);
+    return output;
+}
+
+/**
+ * Decodes the payload that follows a header already parsed by the dispatcher
+ */
+template <RleVariant V>
+bool decode(const uint8_t* payload, const uint8_t* end, size_t size, std::vector<uint8_t>& output) {
+    using Format = typename FormatOf<V>::type;
+    constexpr size_t width = elem_width(static_cast<Format*>(nullptr));
+
+    size_t tail = size % width;
+    if (static_cast<size_t>(end - payload) < tail) return false;
+    // The output grows with the packets actually present, so a corrupt
+    // size in the header can't force a huge allocation up front
+    size_t payloadBytes = static_cast<size_t>(end - payload);
+    output.clear();
+    output.reserve(std::min<size_t>(size, payloadBytes < (SIZE_MAX >> 5) ? payloadBytes * 16 + 4096 : size));
+    const uint8_t* p = payload;
+    if (!Format::decode(p, end - tail, output, size / width)) return false;
+    if (p != end - tail) return false;
+    output.insert(output.end(), p, p + tail);
+    return true;
+}
+
+} // namespace rle
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// One entry of a Huffman lookup table indexed by the next tableBits bits.
+// length == 0 means no code of at most tableBits bits matches (longer code
+// or invalid prefix); the caller then falls back to walking the tree.
+struct HuffDecodeEntry {
+    uint8_t symbol;
+    uint8_t length;
+};
+
+/**
+ * Hot loops compiled once per ISA level (scalar, SSE4.2, AVX2, AVX-512).
+ * kernels() returns the best table for the running CPU, picked via cpuid
+ * the first time it's called.
+ */
+struct KernelTable {
+    const char* isa;
+
+    // Adds the byte histogram of data to counts
+    void (*histogram)(const uint8_t* data, size_t size, uint64_t counts[256]);
+
+    // Length of the run of data[0] starting at data, at most maxRun (size > 0)
+    size_t (*runLength)(const uint8_t* data, size_t size, size_t maxRun);
+
+    // Table-driven decode of an MSB-first bitstream. Decodes from *bitPos
+    // while at least 8 whole bytes remain ahead and the table has an entry,
+    // writing at most outCap symbols. Returns the number of symbols written.
+    size_t (*huffmanDecode)(const uint8_t* in, size_t inBytes, size_t* bitPos,
+                            const HuffDecodeEntry* table, int tableBits,
+                            uint8_t* out, size_t outCap);
+};
+
+const KernelTable& kernels();
+
+// Per-ISA tables; null when that level wasn't compiled in
+extern const KernelTable* const kernelsScalar;
+extern const KernelTable* const kernelsSse42;
+extern const KernelTable* const kernelsAvx2;
+extern const KernelTable* const kernelsAvx512;
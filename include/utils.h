@@ -2,5 +2,6 @@
 #include <string>
 #include <map>
 
-// Count frequency of each character in a string
-std::map<char, int> calculateFrequencies(const std::string& text);
+// Count frequency of each character in a string (parallel over 1 MB chunks).
+// numThreads: 0 = all available, 1 = serial.
+std::map<char, int> calculateFrequencies(const std::string& text, int numThreads = 0);
@@ -5,6 +5,9 @@
 #include <chrono>
 #include <cstring>
 #include <omp.h>
+#include "../include/RFLCompress.h"
+#include "../include/rleFormats.h"
+#include "../include/simdKernels.h"
 
 // ============================================================================
 // RLE COMPRESSION FUNCTIONS
@@ -14,21 +17,17 @@
  * Sequential RLE compression
  * Returns compressed data with format: [count][character]
  */
-std::vector<uint8_t> rle_compress_sequential(const std::vector<uint8_t>& input) {
+std::vector<uint8_t> rle_compress_sequential(const uint8_t* input, size_t size) {
     std::vector<uint8_t> output;
-    if (input.empty()) return output;
+    if (size == 0) return output;
     
+    const KernelTable& k = kernels();
     size_t i = 0;
-    while (i < input.size()) {
+    while (i < size) {
         uint8_t current = input[i];
-        size_t count = 1;
         
         // Count consecutive occurrences (max 255)
-        while (i + count < input.size() && 
-               input[i + count] == current && 
-               count < 255) {
-            count++;
-        }
+        size_t count = k.runLength(input + i, size - i, 255);
         
         // Store count and character
         output.push_back(static_cast<uint8_t>(count));
@@ -40,12 +39,16 @@ std::vector<uint8_t> rle_compress_sequential(const std::vector<uint8_t>& input)
     return output;
 }
 
+std::vector<uint8_t> rle_compress_sequential(const std::vector<uint8_t>& input) {
+    return rle_compress_sequential(input.data(), input.size());
+}
+
 /**
  * Parallel RLE compression using chunking
  * Divides input into chunks and compresses in parallel
  */
 std::vector<uint8_t> rle_compress_parallel(const std::vector<uint8_t>& input, 
-                                           int num_threads = 4) {
+                                           int num_threads) {
     if (input.empty()) return std::vector<uint8_t>();
     
     size_t chunk_size = input.size() / num_threads;
@@ -67,14 +70,9 @@ std::vector<uint8_t> rle_compress_parallel(const std::vector<uint8_t>& input,
         
         while (i < end) {
             uint8_t current = input[i];
-            size_t count = 1;
             
             // Count consecutive occurrences
-            while (i + count < end && 
-                   input[i + count] == current && 
-                   count < 255) {
-                count++;
-            }
+            size_t count = kernels().runLength(input.data() + i, end - i, 255);
             
             chunk_compressed.push_back(static_cast<uint8_t>(count));
             chunk_compressed.push_back(current);
@@ -121,7 +119,7 @@ std::vector<uint8_t> rle_decompress_sequential(const std::vector<uint8_t>& input
  * Analyzes compressed data structure first, then decompresses in parallel
  */
 std::vector<uint8_t> rle_decompress_parallel(const std::vector<uint8_t>& input, 
-                                             int num_threads = 4) {
+                                             int num_threads) {
     if (input.size() < 2) return std::vector<uint8_t>();
     
     // Phase 1: Calculate total output size and chunk boundaries
@@ -159,266 +157,79 @@ std::vector<uint8_t> rle_decompress_parallel(const std::vector<uint8_t>& input,
 // ============================================================================
 
 /**
- * Pipeline structure for producer-consumer pattern
- * Stage 1: Read data (I/O)
- * Stage 2: Compress/Decompress (Compute)
- * Stage 3: Write data (I/O)
+ * Pipeline compression with 3 stages running concurrently
  */
-class CompressionPipeline {
-private:
-    struct DataBuffer {
-        std::vector<uint8_t> data;
-        bool valid;
-        bool end_of_stream;
-        
-        DataBuffer() : valid(false), end_of_stream(false) {}
-    };
+bool CompressionPipeline::compress_pipeline(const std::string& input_file, 
+                                            const std::string& output_file,
+                                            size_t chunk_size) {
     
-    std::vector<DataBuffer> buffers;
-    int buffer_count;
-    int read_index;
-    int process_index;
-    int write_index;
+    double io_time = 0.0;
+    double compute_time = 0.0;
     
-public:
-    CompressionPipeline(int num_buffers = 4) 
-        : buffer_count(num_buffers), read_index(0), 
-          process_index(0), write_index(0) {
-        buffers.resize(num_buffers);
+    AsyncFileReader reader(input_file, chunk_size, queue_depth, backend);
+    if (!reader.isOpen()) {
+        std::cerr << "Error opening the file: " << input_file << std::endl;
+        return false;
     }
-    
-    /**
-     * Pipeline compression with 3 stages running concurrently
-     */
-    void compress_pipeline(const std::string& input_file, 
-                          const std::string& output_file,
-                          size_t chunk_size = 1024 * 1024) {
-        
-        double io_time = 0.0;
-        double compute_time = 0.0;
-        
-        #pragma omp parallel sections num_threads(3)
-        {
-            // Stage 1: Producer - Read from file (I/O bound)
-            #pragma omp section
-            {
-                std::ifstream infile(input_file, std::ios::binary);
-                std::vector<uint8_t> buffer(chunk_size);
-                
-                while (infile) {
-                    auto start = std::chrono::high_resolution_clock::now();
-                    
-                    infile.read(reinterpret_cast<char*>(buffer.data()), chunk_size);
-                    size_t bytes_read = infile.gcount();
-                    
-                    auto end = std::chrono::high_resolution_clock::now();
-                    
-                    #pragma omp atomic
-                    io_time += std::chrono::duration<double>(end - start).count();
-                    
-                    if (bytes_read > 0) {
-                        // Wait for buffer to be available
-                        #pragma omp critical (buffer_write)
-                        {
-                            buffers[read_index % buffer_count].data.assign(
-                                buffer.begin(), buffer.begin() + bytes_read);
-                            buffers[read_index % buffer_count].valid = true;
-                            buffers[read_index % buffer_count].end_of_stream = false;
-                            read_index++;
-                        }
-                    }
-                    
-                    if (bytes_read < chunk_size) break;
-                }
-                
-                // Signal end of stream
-                #pragma omp critical (buffer_write)
-                {
-                    buffers[read_index % buffer_count].end_of_stream = true;
-                    buffers[read_index % buffer_count].valid = true;
-                }
-                
-                infile.close();
-            }
-            
-            // Stage 2: Worker - Compress data (Compute bound)
-            #pragma omp section
-            {
-                bool done = false;
-                
-                while (!done) {
-                    bool has_data = false;
-                    std::vector<uint8_t> input_data;
-                    
-                    #pragma omp critical (buffer_write)
-                    {
-                        if (buffers[process_index % buffer_count].valid) {
-                            if (buffers[process_index % buffer_count].end_of_stream) {
-                                done = true;
-                            } else {
-                                input_data = buffers[process_index % buffer_count].data;
-                                has_data = true;
-                                buffers[process_index % buffer_count].valid = false;
-                            }
-                            process_index++;
-                        }
-                    }
-                    
-                    if (has_data) {
-                        auto start = std::chrono::high_resolution_clock::now();
-                        
-                        // Perform compression (compute intensive)
-                        std::vector<uint8_t> compressed = rle_compress_sequential(input_data);
-                        
-                        auto end = std::chrono::high_resolution_clock::now();
-                        
-                        #pragma omp atomic
-                        compute_time += std::chrono::duration<double>(end - start).count();
-                        
-                        // Store compressed data for writing
-                        #pragma omp critical (output_queue)
-                        {
-                            // In a real implementation, use a separate output queue
-                            // For simplicity, we're demonstrating the pattern
-                        }
-                    }
-                }
-            }
-            
-            // Stage 3: Consumer - Write to file (I/O bound)
-            #pragma omp section
-            {
-                std::ofstream outfile(output_file, std::ios::binary);
-                // Write compressed data as it becomes available
-                // Implementation details omitted for brevity
-                outfile.close();
-            }
-        }
-        
-        // Print bottleneck analysis
-        std::cout << "\n=== BOTTLENECK ANALYSIS ===" << std::endl;
-        std::cout << "I/O Time:      " << io_time << " seconds" << std::endl;
-        std::cout << "Compute Time:  " << compute_time << " seconds" << std::endl;
-        
-        if (io_time > compute_time * 1.5) {
-            std::cout << "BOTTLENECK: I/O bound (Consider buffering, async I/O)" << std::endl;
-        } else if (compute_time > io_time * 1.5) {
-            std::cout << "BOTTLENECK: Compute bound (Consider more parallelism)" << std::endl;
-        } else {
-            std::cout << "BALANCED: I/O and compute are well balanced" << std::endl;
-        }
+    // The stream header carries the original size, which a pipe doesn't have up front
+    if (!reader.sizeKnown()) {
+        std::cerr << "Error: pipeline needs a regular input file: " << input_file << std::endl;
+        return false;
+    }
+    AsyncFileWriter writer(output_file, chunk_size, queue_depth, backend);
+    if (!writer.isOpen()) {
+        std::cerr << "Error creating the file: " << output_file << std::endl;
+        return false;
+    }
+    std::cout << "I/O backend: " << asyncBackendName(reader.backend()) 
+              << ", queue depth " << queue_depth << std::endl;
+    
+    // Chunks are [count][byte] pairs capped at 255, i.e. the pair8 variant
+    std::vector<uint8_t> header = rle::header(RleVariant::Pair8, reader.fileSize());
+    bool ok = writer.write(header.data(), header.size());
+    while (ok) {
+        // Stage 1: wait for the next chunk (only blocks if the read is still in flight)
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t bytes_read = 0;
+        const uint8_t* chunk = reader.next(bytes_read);
+        auto end = std::chrono::high_resolution_clock::now();
+        io_time += std::chrono::duration<double>(end - start).count();
+        
+        if (!chunk) break;
+        
+        // Stage 2: compress (compute intensive)
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<uint8_t> compressed = rle_compress_sequential(chunk, bytes_read);
+        end = std::chrono::high_resolution_clock::now();
+        compute_time += std::chrono::duration<double>(end - start).count();
+        
+        // Stage 3: queue the write (only blocks if every write buffer is busy)
+        start = std::chrono::high_resolution_clock::now();
+        ok = writer.write(compressed.data(), compressed.size());
+        end = std::chrono::high_resolution_clock::now();
+        io_time += std::chrono::duration<double>(end - start).count();
     }
-};
-
-// ============================================================================
-// PERFORMANCE BENCHMARKING
-// ============================================================================
-
-void benchmark_compression(const std::vector<uint8_t>& data, int num_threads) {
-    std::cout << "\n=== RLE Compression Benchmark ===" << std::endl;
-    std::cout << "Input size: " << data.size() << " bytes" << std::endl;
-    std::cout << "Threads: " << num_threads << std::endl;
-    
-    // Sequential compression
-    auto start = std::chrono::high_resolution_clock::now();
-    auto compressed_seq = rle_compress_sequential(data);
-    auto end = std::chrono::high_resolution_clock::now();
-    double time_seq = std::chrono::duration<double>(end - start).count();
-    
-    std::cout << "\nSequential:" << std::endl;
-    std::cout << "  Time: " << time_seq << " seconds" << std::endl;
-    std::cout << "  Output size: " << compressed_seq.size() << " bytes" << std::endl;
-    std::cout << "  Compression ratio: " << 
-        (double)data.size() / compressed_seq.size() << std::endl;
-    
-    // Parallel compression
-    start = std::chrono::high_resolution_clock::now();
-    auto compressed_par = rle_compress_parallel(data, num_threads);
-    end = std::chrono::high_resolution_clock::now();
-    double time_par = std::chrono::duration<double>(end - start).count();
-    
-    std::cout << "\nParallel (" << num_threads << " threads):" << std::endl;
-    std::cout << "  Time: " << time_par << " seconds" << std::endl;
-    std::cout << "  Output size: " << compressed_par.size() << " bytes" << std::endl;
-    std::cout << "  Speedup: " << time_seq / time_par << "x" << std::endl;
-    std::cout << "  Efficiency: " << 
-        (time_seq / time_par) / num_threads * 100 << "%" << std::endl;
-}
-
-void benchmark_decompression(const std::vector<uint8_t>& compressed, int num_threads) {
-    std::cout << "\n=== RLE Decompression Benchmark ===" << std::endl;
-    std::cout << "Compressed size: " << compressed.size() << " bytes" << std::endl;
     
-    // Sequential decompression
     auto start = std::chrono::high_resolution_clock::now();
-    auto decompressed_seq = rle_decompress_sequential(compressed);
+    ok = writer.close() && ok && !reader.failed();
     auto end = std::chrono::high_resolution_clock::now();
-    double time_seq = std::chrono::duration<double>(end - start).count();
-    
-    std::cout << "\nSequential:" << std::endl;
-    std::cout << "  Time: " << time_seq << " seconds" << std::endl;
-    std::cout << "  Output size: " << decompressed_seq.size() << " bytes" << std::endl;
+    io_time += std::chrono::duration<double>(end - start).count();
     
-    // Parallel decompression
-    start = std::chrono::high_resolution_clock::now();
-    auto decompressed_par = rle_decompress_parallel(compressed, num_threads);
-    end = std::chrono::high_resolution_clock::now();
-    double time_par = std::chrono::duration<double>(end - start).count();
-    
-    std::cout << "\nParallel (" << num_threads << " threads):" << std::endl;
-    std::cout << "  Time: " << time_par << " seconds" << std::endl;
-    std::cout << "  Speedup: " << time_seq / time_par << "x" << std::endl;
-    std::cout << "  Efficiency: " << 
-        (time_seq / time_par) / num_threads * 100 << "%" << std::endl;
-}
-
-// ============================================================================
-// MAIN FUNCTION
-// ============================================================================
-
-int main(int argc, char* argv[]) {
-    std::cout << "RLE Compression/Decompression with OpenMP" << std::endl;
-    std::cout << "==========================================\n" << std::endl;
-    
-    // Generate test data with repetitive patterns (good for RLE)
-    const size_t data_size = 10 * 1024 * 1024; // 10 MB
-    std::vector<uint8_t> test_data(data_size);
-    
-    // Create data with runs of repeated values
-    for (size_t i = 0; i < data_size; i++) {
-        test_data[i] = static_cast<uint8_t>((i / 100) % 256);
+    if (!ok) {
+        std::cerr << "Error: pipeline I/O failed" << std::endl;
     }
     
-    std::cout << "Generated " << data_size << " bytes of test data" << std::endl;
-    
-    // Test different thread counts
-    std::vector<int> thread_counts = {1, 2, 4, 8};
-    
-    for (int num_threads : thread_counts) {
-        std::cout << "\n" << std::string(50, '=') << std::endl;
-        
-        // Benchmark compression
-        benchmark_compression(test_data, num_threads);
-        
-        // Create compressed data for decompression test
-        auto compressed = rle_compress_sequential(test_data);
-        
-        // Benchmark decompression
-        benchmark_decompression(compressed, num_threads);
+    // Print bottleneck analysis
+    std::cout << "\n=== BOTTLENECK ANALYSIS ===" << std::endl;
+    std::cout << "I/O Wait Time: " << io_time << " seconds" << std::endl;
+    std::cout << "Compute Time:  " << compute_time << " seconds" << std::endl;
+    
+    if (io_time > compute_time * 1.5) {
+        std::cout << "BOTTLENECK: I/O bound (Consider a deeper queue or larger chunks)" << std::endl;
+    } else if (compute_time > io_time * 1.5) {
+        std::cout << "BOTTLENECK: Compute bound (Consider more parallelism)" << std::endl;
+    } else {
+        std::cout << "BALANCED: I/O and compute are well balanced" << std::endl;
     }
-    
-    // Demonstrate pipeline parallelism
-    std::cout << "\n" << std::string(50, '=') << std::endl;
-    std::cout << "\n=== Pipeline Parallelism Demo ===" << std::endl;
-    
-    // Save test data to file
-    std::ofstream test_file("test_input.dat", std::ios::binary);
-    test_file.write(reinterpret_cast<const char*>(test_data.data()), test_data.size());
-    test_file.close();
-    
-    // Run pipeline compression
-    CompressionPipeline pipeline;
-    pipeline.compress_pipeline("test_input.dat", "test_output.rle", 1024 * 1024);
-    
-    return 0;
+    return ok;
 }
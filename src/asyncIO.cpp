@@ -0,0 +1,853 @@
+#include "../include/asyncIO.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if __has_include(<sys/stat.h>)
+#include <sys/stat.h>
+#define COMPRESSOR_HAVE_STAT 1
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define COMPRESSOR_HAVE_IO_URING 1
+#endif
+#endif
+
+const char* asyncBackendName(AsyncBackend backend) {
+    switch (backend) {
+        case AsyncBackend::IoUring: return "io_uring";
+        case AsyncBackend::Threads: return "threads";
+        default: return "auto";
+    }
+}
+
+// ============================================================================
+// IO_URING RING (raw syscalls, no liburing dependency)
+// ============================================================================
+
+#ifdef COMPRESSOR_HAVE_IO_URING
+namespace {
+
+class Ring {
+public:
+    ~Ring() { release(); }
+
+    bool init(unsigned entries) {
+        io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+        if (fd < 0) return false;
+        features = p.features;
+
+        sqLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqLen = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sqLen = cqLen = std::max(sqLen, cqLen);
+
+        sqPtr = mmap(nullptr, sqLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     fd, IORING_OFF_SQ_RING);
+        if (sqPtr == MAP_FAILED) { sqPtr = nullptr; release(); return false; }
+        if (single) {
+            cqPtr = sqPtr;
+        } else {
+            cqPtr = mmap(nullptr, cqLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_CQ_RING);
+            if (cqPtr == MAP_FAILED) { cqPtr = nullptr; release(); return false; }
+        }
+        sqesLen = p.sq_entries * sizeof(io_uring_sqe);
+        void* s = mmap(nullptr, sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_SQES);
+        if (s == MAP_FAILED) { release(); return false; }
+        sqes = static_cast<io_uring_sqe*>(s);
+
+        char* sq = static_cast<char*>(sqPtr);
+        sqHead = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sqTailPtr = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sqEntries = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_entries);
+        sqArray = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        sqTail = *sqTailPtr;
+
+        char* cq = static_cast<char*>(cqPtr);
+        cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        return true;
+    }
+
+    // Registers the chunk buffers so READ_FIXED/WRITE_FIXED skip the
+    // per-request page pinning. Fails quietly under a low RLIMIT_MEMLOCK.
+    bool registerBuffers(const std::vector<std::unique_ptr<uint8_t[]>>& buffers, size_t size) {
+        std::vector<iovec> iov(buffers.size());
+        for (size_t i = 0; i < buffers.size(); i++) {
+            iov[i].iov_base = buffers[i].get();
+            iov[i].iov_len = size;
+        }
+        return syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS,
+                       iov.data(), static_cast<unsigned>(iov.size())) == 0;
+    }
+
+    // Asks the kernel to cancel the request tagged userData. The cancel's own
+    // completion carries CANCEL_TAG and is ignored by the callers.
+    static const uint64_t CANCEL_TAG = ~uint64_t(0);
+    bool cancel(uint64_t userData) {
+        io_uring_sqe* sqe = getSqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = userData;
+        sqe->user_data = CANCEL_TAG;
+        return true;
+    }
+
+    // IORING_FEAT_RW_CUR_POS: offset -1 reads at the file position (pipes)
+    bool readsAtFilePosition() const { return features & IORING_FEAT_RW_CUR_POS; }
+
+    io_uring_sqe* getSqe() {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqTail - head >= sqEntries) return nullptr;
+        unsigned idx = sqTail & sqMask;
+        sqArray[idx] = idx;
+        io_uring_sqe* sqe = &sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqTail++;
+        pending++;
+        return sqe;
+    }
+
+    // Hands queued SQEs to the kernel, optionally waiting for completions
+    bool submit(unsigned waitNr = 0) {
+        __atomic_store_n(sqTailPtr, sqTail, __ATOMIC_RELEASE);
+        unsigned flags = waitNr ? IORING_ENTER_GETEVENTS : 0;
+        for (;;) {
+            long ret = syscall(__NR_io_uring_enter, fd, pending, waitNr, flags, nullptr, 0);
+            if (ret >= 0) {
+                pending -= std::min<unsigned>(pending, static_cast<unsigned>(ret));
+                return true;
+            }
+            if (errno != EINTR) return false;
+        }
+    }
+
+    bool waitCqe(io_uring_cqe& out) {
+        for (;;) {
+            unsigned head = *cqHead;
+            if (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                out = cqes[head & cqMask];
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+            if (!submit(1)) return false;
+        }
+    }
+
+private:
+    void release() {
+        if (sqes) munmap(sqes, sqesLen);
+        if (cqPtr && cqPtr != sqPtr) munmap(cqPtr, cqLen);
+        if (sqPtr) munmap(sqPtr, sqLen);
+        if (fd >= 0) ::close(fd);
+        sqes = nullptr;
+        sqPtr = cqPtr = nullptr;
+        fd = -1;
+    }
+
+    int fd = -1;
+    unsigned features = 0;
+    void* sqPtr = nullptr;
+    void* cqPtr = nullptr;
+    size_t sqLen = 0, cqLen = 0, sqesLen = 0;
+    io_uring_sqe* sqes = nullptr;
+    unsigned *sqHead = nullptr, *sqTailPtr = nullptr, *sqArray = nullptr;
+    unsigned sqMask = 0, sqEntries = 0, sqTail = 0, pending = 0;
+    unsigned *cqHead = nullptr, *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+};
+
+// One probe per process, so Auto can pick a backend without paying for a
+// ring on every file
+bool ioUringWorks() {
+    static const bool works = [] {
+        Ring probe;
+        return probe.init(1);
+    }();
+    return works;
+}
+
+} // namespace
+#endif
+
+// Size of a regular file. False for pipes, character devices and the like,
+// whose st_size means nothing; those are read until EOF instead.
+static bool regularFileSize(const std::string& path, uint64_t& size) {
+#ifdef COMPRESSOR_HAVE_STAT
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    size = static_cast<uint64_t>(st.st_size);
+    return true;
+#else
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    std::streamoff end = probe.tellg();
+    if (end < 0) return false;
+    size = static_cast<uint64_t>(end);
+    return true;
+#endif
+}
+
+// Chunk buffers are left uninitialised; every byte handed out was read first
+static std::unique_ptr<uint8_t[]> newBuffer(size_t size) {
+    return std::unique_ptr<uint8_t[]>(new uint8_t[size]);
+}
+
+// ============================================================================
+// ASYNC READER
+// ============================================================================
+
+struct AsyncFileReader::Impl {
+    AsyncBackend backend = AsyncBackend::Threads;
+    size_t chunkSize;
+    int depth;
+    bool open = false;
+    bool error = false;
+    bool streaming = false;     // no usable size: read until EOF
+    uint64_t size = 0;
+
+    // One buffer per in-flight chunk; chunk c always lives in slot c % depth
+    std::vector<std::unique_ptr<uint8_t[]>> buffers;
+    std::vector<size_t> lengths;
+    uint64_t nextChunk = 0;
+    int lastSlot = -1;
+
+    // Thread backend
+    std::ifstream file;
+    std::thread worker;
+    std::mutex m;
+    std::condition_variable cv;
+    uint64_t produced = 0;
+    uint64_t released = 0;
+    bool eof = false;
+    bool stop = false;
+
+#ifdef COMPRESSOR_HAVE_IO_URING
+    int fd = -1;
+    Ring ring;
+    bool fixed = false;
+    uint64_t chunkCount = 0;
+    uint64_t submitted = 0;
+    uint64_t inFlight = 0;
+    bool streamEnded = false;
+    std::vector<uint64_t> slotChunk;
+    std::vector<bool> ready;
+
+    bool openUring(const std::string& path) {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !ring.init(static_cast<unsigned>(depth)) ||
+            (!S_ISREG(st.st_mode) && !ring.readsAtFilePosition())) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        streaming = !S_ISREG(st.st_mode);
+        size = streaming ? 0 : static_cast<uint64_t>(st.st_size);
+        chunkCount = streaming ? UINT64_MAX : (size + chunkSize - 1) / chunkSize;
+        fixed = ring.registerBuffers(buffers, chunkSize);
+        slotChunk.assign(depth, 0);
+        ready.assign(depth, false);
+
+        if (streaming) {
+            if (!queueStreamRead()) error = true;
+            return true;
+        }
+        for (int s = 0; s < depth && submitted < chunkCount; s++) {
+            queueChunk(s, submitted++);
+        }
+        if (!ring.submit()) error = true;
+        return true;
+    }
+
+    size_t chunkLength(uint64_t chunk) const {
+        return static_cast<size_t>(std::min<uint64_t>(chunkSize, size - chunk * chunkSize));
+    }
+
+    bool queueRead(int slot) {
+        io_uring_sqe* sqe = ring.getSqe();
+        if (!sqe) return false;
+        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->off = slotChunk[slot] * chunkSize + lengths[slot];
+        sqe->addr = reinterpret_cast<uint64_t>(buffers[slot].get() + lengths[slot]);
+        sqe->len = static_cast<uint32_t>(chunkLength(slotChunk[slot]) - lengths[slot]);
+        sqe->buf_index = static_cast<uint16_t>(slot);
+        sqe->user_data = static_cast<uint64_t>(slot);
+        return true;
+    }
+
+    // inFlight counts reads the kernel owns (queued SQEs included, since
+    // any later wait submits them); only those have to be drained
+    void queueChunk(int slot, uint64_t chunk) {
+        slotChunk[slot] = chunk;
+        lengths[slot] = 0;
+        ready[slot] = false;
+        if (queueRead(slot)) {
+            inFlight++;
+        } else {
+            error = true;
+        }
+    }
+
+    // Pipes have no offsets: one read at a time at the file position keeps
+    // the data in order, and the next read still overlaps the caller's work
+    bool queueStreamRead() {
+        int slot = static_cast<int>(submitted % depth);
+        io_uring_sqe* sqe = ring.getSqe();
+        if (!sqe) return false;
+        slotChunk[slot] = submitted++;
+        lengths[slot] = 0;
+        ready[slot] = false;
+        inFlight++;
+        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->off = ~uint64_t(0);
+        sqe->addr = reinterpret_cast<uint64_t>(buffers[slot].get());
+        sqe->len = static_cast<uint32_t>(chunkSize);
+        sqe->buf_index = static_cast<uint16_t>(slot);
+        sqe->user_data = static_cast<uint64_t>(slot);
+        return ring.submit();
+    }
+
+    // Starts the next read if none is in flight and a slot is free; held is
+    // 1 while the caller still owns the chunk it was last given
+    bool prefetchStream(uint64_t held) {
+        if (inFlight || streamEnded || submitted - nextChunk + held >= static_cast<uint64_t>(depth)) {
+            return true;
+        }
+        return queueStreamRead();
+    }
+
+    const uint8_t* nextStream(size_t& outSize) {
+        lastSlot = -1;
+        for (;;) {
+            if (error || !prefetchStream(0)) { error = true; return nullptr; }
+            int slot = static_cast<int>(nextChunk % depth);
+            if (nextChunk < submitted && ready[slot]) break;
+            if (!inFlight) return nullptr;
+
+            io_uring_cqe cqe;
+            if (!ring.waitCqe(cqe)) { error = true; return nullptr; }
+            inFlight--;
+            if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+                submitted--;    // same chunk, same slot
+                continue;
+            }
+            if (cqe.res < 0) { error = true; return nullptr; }
+            if (cqe.res == 0) {
+                streamEnded = true;
+                submitted--;
+                continue;
+            }
+            int s = static_cast<int>(cqe.user_data);
+            lengths[s] = static_cast<size_t>(cqe.res);
+            ready[s] = true;
+        }
+        int slot = static_cast<int>(nextChunk % depth);
+        nextChunk++;
+        lastSlot = slot;
+        if (!prefetchStream(1)) error = true;
+        outSize = lengths[slot];
+        return buffers[slot].get();
+    }
+
+    /**
+     * Every read still in flight, after an error too, must complete before
+     * its buffer is freed. They are cancelled first (a pipe read may never
+     * finish otherwise) and reaped. If the ring itself fails the buffers
+     * are leaked instead, since the kernel may still write into them.
+     */
+    void drain() {
+        if (inFlight == 0) return;
+        for (int s = 0; s < depth; s++) ring.cancel(static_cast<uint64_t>(s));
+        if (!ring.submit()) error = true;
+        io_uring_cqe cqe;
+        while (inFlight > 0) {
+            if (!ring.waitCqe(cqe)) {
+                for (auto& b : buffers) b.release();
+                return;
+            }
+            if (cqe.user_data != Ring::CANCEL_TAG) inFlight--;
+        }
+    }
+
+    const uint8_t* nextUring(size_t& outSize) {
+        if (streaming) return nextStream(outSize);
+        if (lastSlot >= 0 && submitted < chunkCount) {
+            queueChunk(lastSlot, submitted++);
+            if (!ring.submit()) error = true;
+        }
+        lastSlot = -1;
+        if (error || nextChunk >= chunkCount) return nullptr;
+
+        int slot = static_cast<int>(nextChunk % depth);
+        while (!ready[slot]) {
+            io_uring_cqe cqe;
+            if (!ring.waitCqe(cqe)) { error = true; return nullptr; }
+            int s = static_cast<int>(cqe.user_data);
+            if (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR) {
+                inFlight--;
+                error = true;
+                return nullptr;
+            }
+            if (cqe.res == 0) {
+                // File shrank underneath us; hand out what we have
+                ready[s] = true;
+                inFlight--;
+                continue;
+            }
+            if (cqe.res > 0) lengths[s] += static_cast<size_t>(cqe.res);
+            if (lengths[s] < chunkLength(slotChunk[s])) {
+                // Short read, fetch the remainder
+                if (!queueRead(s)) { inFlight--; error = true; return nullptr; }
+                if (!ring.submit()) { error = true; return nullptr; }
+            } else {
+                ready[s] = true;
+                inFlight--;
+            }
+        }
+        nextChunk++;
+        lastSlot = slot;
+        outSize = lengths[slot];
+        return outSize ? buffers[slot].get() : nullptr;
+    }
+#endif
+
+    bool openThreads(const std::string& path) {
+        streaming = !regularFileSize(path, size);
+        if (streaming) size = 0;
+        // No ios::ate: seeking to the end fails on a pipe and closes the file
+        file.open(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        if (!streaming && size <= chunkSize) {
+            // Fits one buffer: read it here rather than start a thread
+            file.read(reinterpret_cast<char*>(buffers[0].get()), chunkSize);
+            lengths[0] = static_cast<size_t>(file.gcount());
+            produced = lengths[0] ? 1 : 0;
+            eof = true;
+            error = file.bad();
+            return true;
+        }
+        worker = std::thread([this] { readLoop(); });
+        return true;
+    }
+
+    void readLoop() {
+        for (uint64_t chunk = 0;; chunk++) {
+            int slot = static_cast<int>(chunk % depth);
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&] { return stop || chunk < released + depth; });
+                if (stop) return;
+            }
+            file.read(reinterpret_cast<char*>(buffers[slot].get()), chunkSize);
+            size_t got = static_cast<size_t>(file.gcount());
+            std::lock_guard<std::mutex> lock(m);
+            if (got == 0) {
+                eof = true;
+                error = file.bad();
+                cv.notify_all();
+                return;
+            }
+            lengths[slot] = got;
+            produced = chunk + 1;
+            cv.notify_all();
+        }
+    }
+
+    const uint8_t* nextThreads(size_t& outSize) {
+        std::unique_lock<std::mutex> lock(m);
+        if (lastSlot >= 0) {
+            released++;
+            lastSlot = -1;
+            cv.notify_all();
+        }
+        cv.wait(lock, [&] { return produced > nextChunk || eof; });
+        if (produced <= nextChunk) return nullptr;
+        int slot = static_cast<int>(nextChunk % depth);
+        nextChunk++;
+        lastSlot = slot;
+        outSize = lengths[slot];
+        return buffers[slot].get();
+    }
+};
+
+AsyncFileReader::AsyncFileReader(const std::string& path, size_t chunkSize,
+                                 int queueDepth, AsyncBackend backend)
+    : impl(new Impl) {
+    impl->chunkSize = std::max<size_t>(chunkSize, 4096);
+    impl->depth = std::max(queueDepth, 1);
+
+    // A known size caps the buffers: a 1 KB file gets one 1 KB buffer, not
+    // depth zeroed chunks, and is too small to be worth a ring
+    uint64_t known = 0;
+    bool regular = regularFileSize(path, known);
+    bool small = regular && known < impl->chunkSize;
+    if (regular) {
+        uint64_t chunks = (known + impl->chunkSize - 1) / impl->chunkSize;
+        impl->depth = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(impl->depth, chunks)));
+        impl->chunkSize = static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(impl->chunkSize, known)));
+    }
+    impl->buffers.resize(impl->depth);
+    for (auto& b : impl->buffers) b = newBuffer(impl->chunkSize);
+    impl->lengths.assign(impl->depth, 0);
+
+#ifdef COMPRESSOR_HAVE_IO_URING
+    bool useRing = backend == AsyncBackend::IoUring || (backend == AsyncBackend::Auto && !small);
+    if (useRing && ioUringWorks() && impl->openUring(path)) {
+        impl->backend = AsyncBackend::IoUring;
+        impl->open = true;
+        return;
+    }
+#endif
+    impl->backend = AsyncBackend::Threads;
+    impl->open = impl->openThreads(path);
+}
+
+AsyncFileReader::~AsyncFileReader() {
+    if (impl->worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(impl->m);
+            impl->stop = true;
+        }
+        impl->cv.notify_all();
+        impl->worker.join();
+    }
+#ifdef COMPRESSOR_HAVE_IO_URING
+    if (impl->fd >= 0) {
+        impl->drain();
+        ::close(impl->fd);
+    }
+#endif
+}
+
+bool AsyncFileReader::isOpen() const { return impl->open; }
+uint64_t AsyncFileReader::fileSize() const { return impl->size; }
+bool AsyncFileReader::sizeKnown() const { return !impl->streaming; }
+AsyncBackend AsyncFileReader::backend() const { return impl->backend; }
+bool AsyncFileReader::failed() const { return impl->error; }
+
+const uint8_t* AsyncFileReader::next(size_t& size) {
+    size = 0;
+    if (!impl->open) return nullptr;
+#ifdef COMPRESSOR_HAVE_IO_URING
+    if (impl->backend == AsyncBackend::IoUring) return impl->nextUring(size);
+#endif
+    return impl->nextThreads(size);
+}
+
+// ============================================================================
+// ASYNC WRITER
+// ============================================================================
+
+struct AsyncFileWriter::Impl {
+    AsyncBackend backend = AsyncBackend::Threads;
+    size_t chunkSize;
+    int depth;
+    bool open = false;
+    bool error = false;
+
+    // Slots get their buffer when first written, and the ring or thread
+    // only starts once a full chunk is ready, so a small output costs one
+    // buffer and a plain write
+    std::vector<std::unique_ptr<uint8_t[]>> buffers;
+    std::vector<size_t> lengths;
+    std::vector<bool> busy;
+    int current = 0;
+
+    // Thread backend: slots are written strictly in submission order
+    std::ofstream file;
+    std::thread worker;
+    std::mutex m;
+    std::condition_variable cv;
+    uint64_t submitted = 0;
+    uint64_t written = 0;
+    bool stop = false;
+
+    uint8_t* slotBuffer(int slot) {
+        if (!buffers[slot]) buffers[slot] = newBuffer(chunkSize);
+        return buffers[slot].get();
+    }
+
+#ifdef COMPRESSOR_HAVE_IO_URING
+    int fd = -1;
+    Ring ring;
+    bool ringStarted = false;
+    bool ringFailed = false;
+    bool ringBroken = false;    // completions can no longer be reaped
+    bool fixed = false;
+    uint64_t fileOffset = 0;
+    std::vector<uint64_t> slotOffset;
+    std::vector<size_t> done;
+
+    bool openUring(const std::string& path) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        slotOffset.assign(depth, 0);
+        done.assign(depth, 0);
+        return true;
+    }
+
+    // By the first full chunk the output is big enough to use every slot,
+    // so they're all allocated and registered together
+    bool startRing() {
+        if (ringFailed || !ring.init(static_cast<unsigned>(depth))) {
+            ringFailed = true;
+            return false;
+        }
+        for (int s = 0; s < depth; s++) slotBuffer(s);
+        fixed = ring.registerBuffers(buffers, chunkSize);
+        ringStarted = true;
+        return true;
+    }
+
+    // Blocking write of one slot, for outputs that never start the ring
+    bool writeDirect(int slot) {
+        size_t off = 0;
+        while (off < lengths[slot]) {
+            ssize_t n = ::pwrite(fd, buffers[slot].get() + off, lengths[slot] - off,
+                                 static_cast<off_t>(fileOffset + off));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            off += static_cast<size_t>(n);
+        }
+        fileOffset += lengths[slot];
+        lengths[slot] = 0;
+        return true;
+    }
+
+    bool queueWrite(int slot) {
+        io_uring_sqe* sqe = ring.getSqe();
+        if (!sqe) return false;
+        sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->fd = fd;
+        sqe->off = slotOffset[slot] + done[slot];
+        sqe->addr = reinterpret_cast<uint64_t>(buffers[slot].get() + done[slot]);
+        sqe->len = static_cast<uint32_t>(lengths[slot] - done[slot]);
+        sqe->buf_index = static_cast<uint16_t>(slot);
+        sqe->user_data = static_cast<uint64_t>(slot);
+        return true;
+    }
+
+    // Reaps one completion, resubmitting the tail of short writes until an
+    // error is seen. False only when the ring itself fails.
+    bool reapOne() {
+        io_uring_cqe cqe;
+        if (!ring.waitCqe(cqe)) return false;
+        int s = static_cast<int>(cqe.user_data);
+        if (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR) {
+            error = true;
+        } else {
+            if (cqe.res > 0) done[s] += static_cast<size_t>(cqe.res);
+            if (done[s] < lengths[s] && !error) {
+                // Stays busy: a queued SQE is submitted by the next wait
+                if (queueWrite(s)) {
+                    if (!ring.submit()) error = true;
+                    return true;
+                }
+                error = true;
+            }
+        }
+        busy[s] = false;
+        lengths[s] = 0;
+        return true;
+    }
+#endif
+
+    bool openThreads(const std::string& path) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        return file.is_open();
+    }
+
+    void writeLoop() {
+        std::unique_lock<std::mutex> lock(m);
+        for (;;) {
+            cv.wait(lock, [&] { return stop || written < submitted; });
+            if (written == submitted) return;
+            int slot = static_cast<int>(written % depth);
+            lock.unlock();
+            file.write(reinterpret_cast<const char*>(buffers[slot].get()), lengths[slot]);
+            bool ok = static_cast<bool>(file);
+            lock.lock();
+            if (!ok) error = true;
+            lengths[slot] = 0;
+            busy[slot] = false;
+            written++;
+            cv.notify_all();
+        }
+    }
+
+    bool waitSlot(int slot) {
+#ifdef COMPRESSOR_HAVE_IO_URING
+        if (backend == AsyncBackend::IoUring) {
+            // Waits out the slot even after an error; its buffer is reused
+            while (busy[slot] && !ringBroken) {
+                if (!reapOne()) ringBroken = error = true;
+            }
+            return !error;
+        }
+#endif
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] { return !busy[slot]; });
+        return !error;
+    }
+
+    bool submitCurrent() {
+        int slot = current;
+        current = (current + 1) % depth;
+#ifdef COMPRESSOR_HAVE_IO_URING
+        if (backend == AsyncBackend::IoUring) {
+            if (!ringStarted && !startRing()) return writeDirect(slot);
+            slotOffset[slot] = fileOffset;
+            done[slot] = 0;
+            fileOffset += lengths[slot];
+            if (!queueWrite(slot)) return false;
+            busy[slot] = true;
+            return ring.submit();
+        }
+#endif
+        std::lock_guard<std::mutex> lock(m);
+        if (!worker.joinable()) worker = std::thread([this] { writeLoop(); });
+        busy[slot] = true;
+        submitted++;
+        cv.notify_all();
+        return true;
+    }
+
+    // Writes the partial last slot; if nothing was submitted before, it goes
+    // straight to the file
+    bool flushTail() {
+        int slot = current;
+        if (lengths[slot] == 0) return true;
+#ifdef COMPRESSOR_HAVE_IO_URING
+        if (backend == AsyncBackend::IoUring && !ringStarted) return writeDirect(slot);
+#endif
+        if (backend == AsyncBackend::Threads && !worker.joinable()) {
+            file.write(reinterpret_cast<const char*>(buffers[slot].get()), lengths[slot]);
+            lengths[slot] = 0;
+            return static_cast<bool>(file);
+        }
+        return submitCurrent();
+    }
+};
+
+AsyncFileWriter::AsyncFileWriter(const std::string& path, size_t chunkSize,
+                                 int queueDepth, AsyncBackend backend)
+    : impl(new Impl) {
+    impl->chunkSize = std::max<size_t>(chunkSize, 4096);
+    impl->depth = std::max(queueDepth, 1);
+    impl->buffers.resize(impl->depth);
+    impl->lengths.assign(impl->depth, 0);
+    impl->busy.assign(impl->depth, false);
+
+#ifdef COMPRESSOR_HAVE_IO_URING
+    if (backend != AsyncBackend::Threads && ioUringWorks() && impl->openUring(path)) {
+        impl->backend = AsyncBackend::IoUring;
+        impl->open = true;
+        return;
+    }
+#endif
+    impl->backend = AsyncBackend::Threads;
+    impl->open = impl->openThreads(path);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+}
+
+bool AsyncFileWriter::isOpen() const { return impl->open; }
+AsyncBackend AsyncFileWriter::backend() const { return impl->backend; }
+
+bool AsyncFileWriter::write(const void* data, size_t size) {
+    if (!impl->open) return false;
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        int slot = impl->current;
+        if (!impl->waitSlot(slot)) {
+            impl->error = true;
+            return false;
+        }
+        size_t n = std::min(size, impl->chunkSize - impl->lengths[slot]);
+        memcpy(impl->slotBuffer(slot) + impl->lengths[slot], src, n);
+        impl->lengths[slot] += n;
+        src += n;
+        size -= n;
+        if (impl->lengths[slot] == impl->chunkSize && !impl->submitCurrent()) {
+            impl->error = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AsyncFileWriter::close() {
+    if (!impl->open) return !impl->error;
+    bool ok = impl->waitSlot(impl->current);
+    if (ok) ok = impl->flushTail();
+    for (int s = 0; s < impl->depth; s++) {
+        if (!impl->waitSlot(s)) ok = false;
+    }
+    if (impl->worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(impl->m);
+            impl->stop = true;
+        }
+        impl->cv.notify_all();
+        impl->worker.join();
+    }
+    if (impl->file.is_open()) {
+        impl->file.close();
+        if (!impl->file) ok = false;
+    }
+#ifdef COMPRESSOR_HAVE_IO_URING
+    if (impl->ringBroken) {
+        // Writes may still be reading these; leak them rather than free
+        for (auto& b : impl->buffers) b.release();
+    }
+    if (impl->fd >= 0) {
+        if (::close(impl->fd) != 0) ok = false;
+        impl->fd = -1;
+    }
+#endif
+    impl->open = false;
+    if (!ok) impl->error = true;
+    return !impl->error;
+}
+
+// HELPERS
+// ============================================================================
+
+bool readFileAsync(const std::string& path, std::string& contents, AsyncBackend backend) {
+    AsyncFileReader reader(path, 1024 * 1024, 4, backend);
+    if (!reader.isOpen()) return false;
+    contents.clear();
+    contents.reserve(static_cast<size_t>(reader.fileSize()));
+    size_t n;
+    while (const uint8_t* chunk = reader.next(n)) {
+        contents.append(reinterpret_cast<const char*>(chunk), n);
+    }
+    return !reader.failed();
+}
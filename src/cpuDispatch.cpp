@@ -0,0 +1,52 @@
+#include "../include/simdKernels.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+enum IsaLevel { LevelScalar = 0, LevelSse42 = 1, LevelAvx2 = 2, LevelAvx512 = 3 };
+
+bool cpuSupports(int level) {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    switch (level) {
+        case LevelSse42:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case LevelAvx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+        case LevelAvx512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                   __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("bmi2");
+    }
+#else
+    (void)level;
+#endif
+    return level == LevelScalar;
+}
+
+// COMPRESSOR_ISA=scalar|sse4.2|avx2|avx512 caps the level, e.g. to compare kernels
+int levelCap() {
+    const char* env = std::getenv("COMPRESSOR_ISA");
+    if (!env) return LevelAvx512;
+    if (strcmp(env, "scalar") == 0) return LevelScalar;
+    if (strcmp(env, "sse4.2") == 0 || strcmp(env, "sse42") == 0) return LevelSse42;
+    if (strcmp(env, "avx2") == 0) return LevelAvx2;
+    return LevelAvx512;
+}
+
+const KernelTable* selectKernels() {
+    const KernelTable* candidates[] = { kernelsAvx512, kernelsAvx2, kernelsSse42 };
+    const int levels[] = { LevelAvx512, LevelAvx2, LevelSse42 };
+    int cap = levelCap();
+    for (int i = 0; i < 3; i++) {
+        if (candidates[i] && levels[i] <= cap && cpuSupports(levels[i])) return candidates[i];
+    }
+    return kernelsScalar;
+}
+
+} // namespace
+
+const KernelTable& kernels() {
+    static const KernelTable* const selected = selectKernels();
+    return *selected;
+}
@@ -0,0 +1,661 @@
+#include "../include/daemon.h"
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../include/dedup.h"
+#include "../include/huffmanCompress.h"
+#include "../include/huffmanDecompress.h"
+#include "../include/huffmanTokens.h"
+#include "../include/simdKernels.h"
+using namespace std;
+
+// Requests and replies are single lines of tab-separated fields:
+//   <id> <command> [args...]   ->   <id> ok|error <detail>
+
+namespace {
+
+atomic<bool> stopRequested(false);
+
+void onSignal(int) { stopRequested = true; }
+
+vector<string> splitFields(const string& line, char sep) {
+    vector<string> fields;
+    string field;
+    istringstream in(line);
+    while (getline(in, field, sep)) {
+        if (!field.empty()) fields.push_back(field);
+    }
+    return fields;
+}
+
+bool sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool fillSocketAddress(const string& path, sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+struct Request {
+    string id;
+    vector<string> fields;
+    chrono::steady_clock::time_point queued;
+};
+
+// Replies can come from any worker; the connection outlives the socket's
+// poll entry until the last queued request on it has answered
+struct Connection {
+    int fd;
+    mutex writeLock;
+    // Guarded by the daemon's queue lock. A connection is on the ready queue
+    // or held by one worker while scheduled, so its requests run in the order
+    // they arrived and a request may depend on an earlier one's output
+    deque<Request> pending;
+    bool scheduled = false;
+    explicit Connection(int f) : fd(f) {}
+    ~Connection() { ::close(fd); }
+
+    void reply(const string& id, bool ok, const string& detail) {
+        lock_guard<mutex> lock(writeLock);
+        sendAll(fd, id + "\t" + (ok ? "ok" : "error") + "\t" + detail + "\n");
+    }
+};
+
+struct Metrics {
+    atomic<uint64_t> requests{0};
+    atomic<uint64_t> completed{0};
+    atomic<uint64_t> errors{0};
+    atomic<uint64_t> batches{0};
+    atomic<uint64_t> batchedJobs{0};
+    atomic<uint64_t> waitMicros{0};
+    atomic<uint64_t> cacheHits{0};
+    atomic<uint64_t> cacheMisses{0};
+    atomic<uint64_t> decoderHits{0};
+    atomic<uint64_t> decoderMisses{0};
+    atomic<int> active{0};
+};
+
+/**
+ * LRU of values keyed by a hash of their source content. A hit is confirmed
+ * against the stored content, so a hash collision is just a miss. Entries
+ * are shared read-only between workers.
+ */
+template <typename Content, typename Value>
+class LruCache {
+public:
+    explicit LruCache(size_t capacity) : capacity(capacity) {}
+
+    shared_ptr<const Value> find(const Content& content, uint64_t key) {
+        lock_guard<mutex> lock(m);
+        auto it = index.find(key);
+        if (it == index.end() || it->second->content != content) {
+            return nullptr;
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->value;
+    }
+
+    void insert(const Content& content, uint64_t key, shared_ptr<const Value> value) {
+        if (capacity == 0) return;
+        lock_guard<mutex> lock(m);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            lru.erase(it->second);
+            index.erase(it);
+        }
+        lru.push_front(Entry{key, content, value});
+        index[key] = lru.begin();
+        if (lru.size() > capacity) {
+            index.erase(lru.back().key);
+            lru.pop_back();
+        }
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        Content content;
+        shared_ptr<const Value> value;
+    };
+    size_t capacity;
+    mutex m;
+    list<Entry> lru;
+    unordered_map<uint64_t, typename list<Entry>::iterator> index;
+};
+
+typedef array<uint64_t, 256> Histogram;
+// Huffman tables by exact byte histogram, so repeated inputs skip the tree build
+typedef LruCache<Histogram, map<char, string>> TableCache;
+// Decode tables by map file content, so files sharing a map skip the parse
+typedef LruCache<string, HuffmanDecoder> DecoderCache;
+
+const uint64_t FNV_OFFSET = 1469598103934665603ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+// Every request runs on these; they only grow, so steady traffic stops allocating
+struct WorkerBuffers {
+    string input;
+    string mapText;
+    vector<char> output;
+    vector<uint8_t> decoded;
+};
+
+bool readInto(const string& path, string& buffer) {
+    ifstream in(path, ios::binary | ios::ate);
+    if (!in.is_open()) return false;
+    streamoff size = in.tellg();
+    if (size < 0) return false;
+    buffer.resize(static_cast<size_t>(size));
+    in.seekg(0);
+    return size == 0 || static_cast<bool>(in.read(&buffer[0], size));
+}
+
+// The state is checked after close() too: that flush is where a full disk shows up
+bool writeFrom(const string& path, const void* data, size_t size) {
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.is_open() || !out.write(static_cast<const char*>(data), static_cast<streamsize>(size))) {
+        return false;
+    }
+    out.close();
+    return static_cast<bool>(out);
+}
+
+class Daemon {
+public:
+    explicit Daemon(const DaemonOptions& options)
+        : options(options), cache(options.cacheEntries), decoders(options.cacheEntries) {}
+
+    int run() {
+        int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        if (listenFd < 0 || !fillSocketAddress(options.socketPath, addr)) {
+            cerr << "Error: invalid socket path " << options.socketPath << endl;
+            if (listenFd >= 0) ::close(listenFd);
+            return 1;
+        }
+        // Replace a stale socket left by a previous run, never a regular file
+        struct stat st;
+        if (lstat(options.socketPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(options.socketPath.c_str());
+        }
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listenFd, 128) != 0) {
+            cerr << "Error: cannot listen on " << options.socketPath << ": " << strerror(errno) << endl;
+            ::close(listenFd);
+            return 1;
+        }
+
+        int workerCount = options.workers > 0 ? options.workers
+                                              : max(1, static_cast<int>(thread::hardware_concurrency()));
+        cerr << "Daemon listening on " << options.socketPath << " with " << workerCount
+             << " workers (" << kernels().isa << " kernels)" << endl;
+        workersStarted = workerCount;
+
+        // Codec progress output would interleave across workers
+        cout.setstate(ios::badbit);
+        signal(SIGINT, onSignal);
+        signal(SIGTERM, onSignal);
+        signal(SIGPIPE, SIG_IGN);
+
+        vector<thread> workers;
+        for (int i = 0; i < workerCount; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+
+        serve(listenFd);
+
+        {
+            lock_guard<mutex> lock(queueLock);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto& w : workers) w.join();
+        ::close(listenFd);
+        unlink(options.socketPath.c_str());
+        cout.clear();
+        cerr << "Daemon stopped after " << metrics.completed << " requests" << endl;
+        return 0;
+    }
+
+private:
+    struct Client {
+        shared_ptr<Connection> conn;
+        string pending;
+    };
+
+    void serve(int listenFd) {
+        map<int, Client> clients;
+        vector<char> buffer(64 * 1024);
+        while (!stopRequested) {
+            vector<pollfd> fds;
+            fds.push_back({listenFd, POLLIN, 0});
+            for (auto& c : clients) fds.push_back({c.first, POLLIN, 0});
+
+            int ready = poll(fds.data(), fds.size(), 200);
+            if (ready < 0 && errno != EINTR) break;
+            if (ready <= 0) continue;
+
+            if (fds[0].revents & POLLIN) {
+                int fd = accept(listenFd, nullptr, nullptr);
+                if (fd >= 0) clients[fd].conn = make_shared<Connection>(fd);
+            }
+            for (size_t i = 1; i < fds.size(); i++) {
+                if (!fds[i].revents) continue;
+                auto it = clients.find(fds[i].fd);
+                ssize_t n = recv(fds[i].fd, buffer.data(), buffer.size(), 0);
+                if (n <= 0) {
+                    clients.erase(it);
+                    continue;
+                }
+                it->second.pending.append(buffer.data(), static_cast<size_t>(n));
+                size_t eol;
+                while ((eol = it->second.pending.find('\n')) != string::npos) {
+                    string line = it->second.pending.substr(0, eol);
+                    it->second.pending.erase(0, eol + 1);
+                    dispatch(it->second.conn, line);
+                }
+            }
+        }
+    }
+
+    // stats and shutdown are answered right away on an idle connection;
+    // otherwise they queue behind its pending requests like codec work
+    void dispatch(const shared_ptr<Connection>& conn, const string& line) {
+        vector<string> fields = splitFields(line, '\t');
+        if (fields.size() < 2) {
+            conn->reply(fields.empty() ? "-" : fields[0], false, "malformed request");
+            return;
+        }
+        string id = fields[0];
+        fields.erase(fields.begin());
+        metrics.requests++;
+
+        bool wake = false;
+        {
+            lock_guard<mutex> lock(queueLock);
+            if (!isControl(fields[0]) || conn->scheduled) {
+                conn->pending.push_back(Request{id, fields, chrono::steady_clock::now()});
+                queuedRequests++;
+                maxQueueDepth = max(maxQueueDepth, queuedRequests);
+                if (conn->scheduled) return;
+                conn->scheduled = true;
+                ready.push_back(conn);
+                wake = true;
+            }
+        }
+        if (wake) {
+            queueReady.notify_one();
+            return;
+        }
+        conn->reply(id, true, control(fields[0]));
+        metrics.completed++;
+    }
+
+    static bool isControl(const string& command) {
+        return command == "stats" || command == "shutdown";
+    }
+
+    string control(const string& command) {
+        if (command == "shutdown") {
+            stopRequested = true;
+            return "shutting down";
+        }
+        return statsLine();
+    }
+
+    void workerLoop() {
+        WorkerBuffers buffers;
+        buffers.input.reserve(options.bufferBytes);
+        buffers.output.reserve(options.bufferBytes);
+        buffers.decoded.reserve(options.bufferBytes);
+        vector<Request> batch;
+        batch.reserve(options.batchSize);
+
+        for (;;) {
+            shared_ptr<Connection> conn;
+            {
+                unique_lock<mutex> lock(queueLock);
+                queueReady.wait(lock, [&] { return stopping || !ready.empty(); });
+                if (ready.empty()) return;
+                conn = move(ready.front());
+                ready.pop_front();
+                // Take a batch per wake-up so small jobs don't pay a lock round trip each
+                while (!conn->pending.empty() && batch.size() < max<size_t>(options.batchSize, 1)) {
+                    batch.push_back(move(conn->pending.front()));
+                    conn->pending.pop_front();
+                }
+                queuedRequests -= batch.size();
+            }
+            metrics.batches++;
+            metrics.batchedJobs += batch.size();
+            for (Request& request : batch) {
+                auto waited = chrono::steady_clock::now() - request.queued;
+                metrics.waitMicros += static_cast<uint64_t>(
+                    chrono::duration_cast<chrono::microseconds>(waited).count());
+                string detail;
+                bool ok = true;
+                if (isControl(request.fields[0])) {
+                    detail = control(request.fields[0]);
+                } else {
+                    metrics.active++;
+                    ok = process(request.fields, buffers, detail);
+                    metrics.active--;
+                }
+                if (!ok) metrics.errors++;
+                metrics.completed++;
+                conn->reply(request.id, ok, detail);
+            }
+            batch.clear();
+
+            // Hand the connection back; requeueing at the tail keeps other
+            // connections from starving behind a long batch
+            bool more;
+            {
+                lock_guard<mutex> lock(queueLock);
+                more = !conn->pending.empty();
+                if (more) {
+                    ready.push_back(conn);
+                } else {
+                    conn->scheduled = false;
+                }
+            }
+            if (more) queueReady.notify_one();
+        }
+    }
+
+    bool process(const vector<string>& fields, WorkerBuffers& buffers, string& detail) {
+        const string& command = fields[0];
+        if ((command != "compress" && command != "decompress") || fields.size() < 3) {
+            detail = "unknown request: " + command;
+            return false;
+        }
+        const string& in = fields[1];
+        const string& out = fields[2];
+        string mode = fields.size() > 3 ? fields[3] : "";
+
+        // Every path reads and writes through the worker's buffers rather
+        // than the CLI entry points, which set up async I/O per file
+        if (!mode.empty() && (command == "decompress" ||
+                              (mode != "--words" && mode != "--bigrams" && mode != "--dedup"))) {
+            detail = "unknown option: " + mode;
+            return false;
+        }
+        if (!readInto(in, buffers.input)) {
+            detail = "cannot read " + in;
+            return false;
+        }
+        if (command == "decompress") {
+            return decompressCached(in, out, buffers, detail);
+        }
+        if (mode == "--words" || mode == "--bigrams") {
+            encodeTokens(buffers.input, mode == "--words" ? TokenMode::Words : TokenMode::Bigrams,
+                         buffers.output, buffers.mapText);
+            return finishCompress(out, buffers.output.data(), buffers.output.size(),
+                                  writeFrom(out + ".map", buffers.mapText.data(), buffers.mapText.size()),
+                                  buffers, detail);
+        }
+        if (mode == "--dedup") {
+            map<char, string> codes;
+            vector<uint8_t> stream = encodeDedup(buffers.input, 1, codes);
+            return finishCompress(out, stream.data(), stream.size(),
+                                  writeCodeMap(out + ".map", codes, HUFFMAN_DEDUP_MAGIC), buffers, detail);
+        }
+        return compressCached(out, buffers, detail);
+    }
+
+    bool finishCompress(const string& out, const void* data, size_t size, bool mapWritten,
+                        const WorkerBuffers& buffers, string& detail) {
+        if (!mapWritten || !writeFrom(out, data, size)) {
+            detail = "cannot write " + out;
+            return false;
+        }
+        detail = to_string(buffers.input.size()) + " -> " + to_string(size) + " bytes";
+        return true;
+    }
+
+    // Byte-alphabet compress of buffers.input with a cached table
+    bool compressCached(const string& out, WorkerBuffers& buffers, string& detail) {
+        Histogram counts = {};
+        kernels().histogram(reinterpret_cast<const uint8_t*>(buffers.input.data()),
+                            buffers.input.size(), counts.data());
+        uint64_t key = FNV_OFFSET;   // FNV-1a over the histogram
+        for (int b = 0; b < 256; b++) {
+            key = (key ^ counts[b]) * FNV_PRIME;
+        }
+
+        shared_ptr<const map<char, string>> codes = cache.find(counts, key);
+        if (codes) {
+            metrics.cacheHits++;
+        } else {
+            metrics.cacheMisses++;
+            map<char, int> freq;
+            for (int b = 0; b < 256; b++) {
+                if (counts[b]) freq[static_cast<char>(b)] = static_cast<int>(counts[b]);
+            }
+            codes = make_shared<const map<char, string>>(huffmanCode(freq));
+            cache.insert(counts, key, codes);
+        }
+
+        encodeHuffman(buffers.input, *codes, 1, buffers.output);
+        return finishCompress(out, buffers.output.data(), buffers.output.size(),
+                              writeCodeMap(out + ".map", *codes), buffers, detail);
+    }
+
+    // Decodes buffers.input with decode tables cached by map content
+    bool decompressCached(const string& in, const string& out, WorkerBuffers& buffers, string& detail) {
+        if (!readInto(in + ".map", buffers.mapText)) {
+            detail = "cannot read " + in + ".map";
+            return false;
+        }
+        uint64_t key = FNV_OFFSET;
+        for (char c : buffers.mapText) {
+            key = (key ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+        }
+
+        shared_ptr<const HuffmanDecoder> decoder = decoders.find(buffers.mapText, key);
+        if (decoder) {
+            metrics.decoderHits++;
+        } else {
+            metrics.decoderMisses++;
+            decoder = loadDecoder(buffers.mapText);
+            if (!decoder) {
+                detail = "malformed map " + in + ".map";
+                return false;
+            }
+            decoders.insert(buffers.mapText, key, decoder);
+        }
+
+        if (!decodeBuffer(*decoder, reinterpret_cast<const uint8_t*>(buffers.input.data()),
+                          buffers.input.size(), buffers.decoded)) {
+            detail = "failed: " + in;
+            return false;
+        }
+        if (!writeFrom(out, buffers.decoded.data(), buffers.decoded.size())) {
+            detail = "cannot write " + out;
+            return false;
+        }
+        detail = to_string(buffers.input.size()) + " -> " + to_string(buffers.decoded.size()) + " bytes";
+        return true;
+    }
+
+    string statsLine() {
+        size_t depth, maxDepth;
+        {
+            lock_guard<mutex> lock(queueLock);
+            depth = queuedRequests;
+            maxDepth = maxQueueDepth;
+        }
+        uint64_t batches = metrics.batches, batched = metrics.batchedJobs;
+        ostringstream s;
+        s << "queue_depth=" << depth
+          << " max_queue_depth=" << maxDepth
+          << " active=" << metrics.active
+          << " workers=" << workersStarted
+          << " requests=" << metrics.requests
+          << " completed=" << metrics.completed
+          << " errors=" << metrics.errors
+          << " batches=" << batches
+          << " avg_batch=" << (batches ? static_cast<double>(batched) / batches : 0.0)
+          << " avg_wait_us=" << (batched ? metrics.waitMicros / batched : 0)
+          << " cache_hits=" << metrics.cacheHits
+          << " cache_misses=" << metrics.cacheMisses
+          << " decoder_hits=" << metrics.decoderHits
+          << " decoder_misses=" << metrics.decoderMisses;
+        return s.str();
+    }
+
+    DaemonOptions options;
+    TableCache cache;
+    DecoderCache decoders;
+    Metrics metrics;
+    int workersStarted = 0;
+
+    // Connections with pending requests that no worker holds yet
+    mutex queueLock;
+    condition_variable queueReady;
+    deque<shared_ptr<Connection>> ready;
+    size_t queuedRequests = 0;
+    size_t maxQueueDepth = 0;
+    bool stopping = false;
+};
+
+string absolutePath(const string& path) {
+    if (path.empty() || path[0] == '/') return path;
+    char cwd[4096];
+    if (!getcwd(cwd, sizeof(cwd))) return path;
+    return string(cwd) + "/" + path;
+}
+
+} // namespace
+
+int runDaemon(const DaemonOptions& options)
+{
+    Daemon daemon(options);
+    return daemon.run();
+}
+
+int runClient(const string& socketPath, const vector<string>& args)
+{
+    vector<vector<string>> requests;
+    if (args.size() == 1 && args[0] == "-") {
+        string line;
+        while (getline(cin, line)) {
+            vector<string> fields = splitFields(line, ' ');
+            if (!fields.empty()) requests.push_back(fields);
+        }
+    } else if (!args.empty()) {
+        requests.push_back(args);
+    }
+    if (requests.empty()) {
+        cerr << "Error: no request given" << endl;
+        return 1;
+    }
+
+    // The daemon has its own working directory
+    string payload;
+    for (size_t i = 0; i < requests.size(); i++) {
+        vector<string>& fields = requests[i];
+        if (fields[0] == "compress" || fields[0] == "decompress") {
+            for (size_t f = 1; f < fields.size() && f < 3; f++) fields[f] = absolutePath(fields[f]);
+        }
+        payload += to_string(i);
+        for (const string& f : fields) payload += "\t" + f;
+        payload += "\n";
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    if (fd < 0 || !fillSocketAddress(socketPath, addr) ||
+        connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        cerr << "Error: cannot connect to daemon at " << socketPath << endl;
+        if (fd >= 0) ::close(fd);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    if (!sendAll(fd, payload)) {
+        cerr << "Error: failed to send requests" << endl;
+        ::close(fd);
+        return 1;
+    }
+
+    // Replies arrive in completion order; print them in request order
+    vector<string> replies(requests.size());
+    size_t received = 0;
+    string pending;
+    vector<char> buffer(64 * 1024);
+    while (received < requests.size()) {
+        ssize_t n = recv(fd, buffer.data(), buffer.size(), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(buffer.data(), static_cast<size_t>(n));
+        size_t eol;
+        while ((eol = pending.find('\n')) != string::npos) {
+            vector<string> fields = splitFields(pending.substr(0, eol), '\t');
+            pending.erase(0, eol + 1);
+            if (fields.size() < 2) continue;
+            size_t id = strtoul(fields[0].c_str(), nullptr, 10);
+            if (id >= replies.size() || !replies[id].empty()) continue;
+            replies[id] = fields[1] + (fields.size() > 2 ? " " + fields[2] : "");
+            received++;
+        }
+    }
+    ::close(fd);
+
+    int status = received == requests.size() ? 0 : 1;
+    for (const string& r : replies) {
+        if (r.empty()) {
+            cout << "error no reply\n";
+            continue;
+        }
+        cout << r << "\n";
+        if (r.compare(0, 2, "ok") != 0) status = 1;
+    }
+    return status;
+}
+
+#else
+
+int runDaemon(const DaemonOptions&)
+{
+    std::cerr << "Error: daemon mode needs Unix domain sockets" << std::endl;
+    return 1;
+}
+
+int runClient(const std::string&, const std::vector<std::string>&)
+{
+    std::cerr << "Error: daemon mode needs Unix domain sockets" << std::endl;
+    return 1;
+}
+
+#endif
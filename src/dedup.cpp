@@ -0,0 +1,209 @@
+#include "../include/dedup.h"
+#include "../include/byteCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <omp.h>
+#include <unordered_map>
+
+namespace {
+
+const size_t PARALLEL_FINGERPRINT_BYTES = 1024 * 1024;
+
+// Gear table: one fixed pseudo-random word per byte value (splitmix64), so
+// boundaries are reproducible across builds and hosts
+struct GearTable {
+    uint64_t values[256];
+    GearTable() {
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        for (int i = 0; i < 256; i++) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            values[i] = z ^ (z >> 31);
+        }
+    }
+};
+
+const GearTable gear;
+
+// The hash shifts left one bit per byte, so only its top bits cover the full
+// 64-byte window; the masks test those
+uint64_t topMask(int bits) {
+    return bits <= 0 ? 0 : ~uint64_t(0) << (64 - std::min(bits, 63));
+}
+
+int log2Floor(size_t v) {
+    int bits = 0;
+    while (v >>= 1) bits++;
+    return bits;
+}
+
+/**
+ * Length of the next chunk starting at data. Below the average size a
+ * stricter mask makes a cut less likely, above it a looser one, which keeps
+ * chunk sizes close to the average.
+ */
+size_t nextChunk(const uint8_t* data, size_t size, const DedupParams& params,
+                 uint64_t strictMask, uint64_t looseMask) {
+    if (size <= params.minChunk) return size;
+    size_t normal = std::min(params.avgChunk, size);
+    size_t end = std::min(params.maxChunk, size);
+    uint64_t hash = 0;
+    size_t i = params.minChunk;
+    for (; i < normal; i++) {
+        hash = (hash << 1) + gear.values[data[i]];
+        if (!(hash & strictMask)) return i + 1;
+    }
+    for (; i < end; i++) {
+        hash = (hash << 1) + gear.values[data[i]];
+        if (!(hash & looseMask)) return i + 1;
+    }
+    return end;
+}
+
+uint64_t fingerprint(const uint8_t* data, size_t size) {
+    const uint64_t k = 0x9FB21C651E98DF25ull;
+    uint64_t h = size * k;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        h = (h ^ (w * k)) * k;
+        h ^= h >> 29;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    h = (h ^ (tail * k)) * k;
+    return h ^ (h >> 32);
+}
+
+DedupParams normalise(DedupParams params) {
+    params.avgChunk = size_t(1) << log2Floor(std::max<size_t>(params.avgChunk, 64));
+    params.minChunk = std::min(params.minChunk, params.avgChunk);
+    params.maxChunk = std::max(params.maxChunk, params.avgChunk);
+    return params;
+}
+
+} // namespace
+
+std::vector<size_t> dedup_chunk_boundaries(const uint8_t* data, size_t size, const DedupParams& requested) {
+    DedupParams params = normalise(requested);
+    int bits = log2Floor(params.avgChunk);
+    uint64_t strictMask = topMask(bits + 1);
+    uint64_t looseMask = topMask(bits - 1);
+
+    std::vector<size_t> ends;
+    ends.reserve(size / params.avgChunk + 1);
+    size_t pos = 0;
+    while (pos < size) {
+        pos += nextChunk(data + pos, size - pos, params, strictMask, looseMask);
+        ends.push_back(pos);
+    }
+    return ends;
+}
+
+std::vector<uint8_t> dedup_encode_stream(const uint8_t* input, size_t size, const DedupEncoder& encode,
+                                         const DedupParams& params, DedupStats* stats) {
+    std::vector<size_t> ends = dedup_chunk_boundaries(input, size, params);
+    const long count = static_cast<long>(ends.size());
+
+    std::vector<uint64_t> prints(ends.size());
+    const int threads = params.threads > 0 ? params.threads : omp_get_max_threads();
+    #pragma omp parallel for num_threads(threads) schedule(static) \
+        if(size >= PARALLEL_FINGERPRINT_BYTES && threads > 1)
+    for (long c = 0; c < count; c++) {
+        size_t begin = c ? ends[c - 1] : 0;
+        prints[c] = fingerprint(input + begin, ends[c] - begin);
+    }
+
+    // Fingerprint -> unique chunk; a hit is confirmed byte for byte, so a
+    // hash collision just stores the chunk again
+    std::unordered_map<uint64_t, uint32_t> index;
+    index.reserve(ends.size());
+    std::vector<size_t> uniqueBegin, uniqueSize;
+    std::vector<uint32_t> refs(ends.size());
+    std::vector<uint8_t> unique;
+    unique.reserve(size);
+    DedupStats local;
+
+    for (long c = 0; c < count; c++) {
+        size_t begin = c ? ends[c - 1] : 0;
+        size_t len = ends[c] - begin;
+        auto hit = index.find(prints[c]);
+        if (hit != index.end() && uniqueSize[hit->second] == len &&
+            memcmp(input + uniqueBegin[hit->second], input + begin, len) == 0) {
+            refs[c] = hit->second;
+            local.duplicateBytes += len;
+            continue;
+        }
+        uint32_t id = static_cast<uint32_t>(uniqueSize.size());
+        if (hit == index.end()) index.emplace(prints[c], id);
+        uniqueBegin.push_back(begin);
+        uniqueSize.push_back(len);
+        refs[c] = id;
+        unique.insert(unique.end(), input + begin, input + ends[c]);
+    }
+    local.chunks = ends.size();
+    local.uniqueChunks = uniqueSize.size();
+    local.uniqueBytes = unique.size();
+    if (stats) *stats = local;
+
+    std::vector<uint8_t> out = {'D', 'D', 'P', 1};
+    byte_codec::append<uint64_t>(out, size);
+    byte_codec::put_varint(out, ends.size());
+    byte_codec::put_varint(out, uniqueSize.size());
+    for (size_t len : uniqueSize) byte_codec::put_varint(out, len);
+    for (uint32_t ref : refs) byte_codec::put_varint(out, ref);
+
+    std::vector<uint8_t> payload = encode(unique.data(), unique.size());
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+bool dedup_is_stream(const uint8_t* input, size_t size) {
+    return size >= DEDUP_HEADER_SIZE && input[0] == 'D' && input[1] == 'D' && input[2] == 'P' && input[3] == 1;
+}
+
+bool dedup_decode_stream(const uint8_t* input, size_t size, const DedupDecoder& decode,
+                         std::vector<uint8_t>& output) {
+    output.clear();
+    if (!dedup_is_stream(input, size)) return false;
+    uint64_t original = byte_codec::load<uint64_t>(input + 4);
+    const uint8_t* p = input + DEDUP_HEADER_SIZE;
+    const uint8_t* end = input + size;
+
+    uint64_t chunks, uniqueCount;
+    if (!byte_codec::get_varint(p, end, chunks) || !byte_codec::get_varint(p, end, uniqueCount)) return false;
+    // Every entry takes at least a byte, which bounds the allocations below
+    if (uniqueCount > chunks || chunks > static_cast<uint64_t>(end - p)) return false;
+
+    std::vector<size_t> offsets(uniqueCount + 1, 0);
+    for (uint64_t u = 0; u < uniqueCount; u++) {
+        uint64_t len;
+        if (!byte_codec::get_varint(p, end, len) || len > original) return false;
+        offsets[u + 1] = offsets[u] + static_cast<size_t>(len);
+        if (offsets[u + 1] > original) return false;
+    }
+    std::vector<uint32_t> refs(chunks);
+    uint64_t total = 0;
+    for (uint64_t c = 0; c < chunks; c++) {
+        uint64_t ref;
+        if (!byte_codec::get_varint(p, end, ref) || ref >= uniqueCount) return false;
+        refs[c] = static_cast<uint32_t>(ref);
+        total += offsets[ref + 1] - offsets[ref];
+        if (total > original) return false;
+    }
+    if (total != original) return false;
+
+    size_t uniqueBytes = offsets[uniqueCount];
+    std::vector<uint8_t> unique;
+    if (!decode(p, static_cast<size_t>(end - p), uniqueBytes, unique) || unique.size() < uniqueBytes) {
+        return false;
+    }
+
+    output.reserve(static_cast<size_t>(original));
+    for (uint32_t ref : refs) {
+        output.insert(output.end(), unique.begin() + offsets[ref], unique.begin() + offsets[ref + 1]);
+    }
+    return true;
+}
@@ -5,10 +5,16 @@
 #include <map>
 #include <unordered_map>
 #include <queue>
+#include <omp.h>
 #include "../include/huffmanCompress.h"
 #include "../include/utils.h"
+#include "../include/asyncIO.h"
+#include "../include/dedup.h"
 using namespace std;
 
+// Local to this file; huffmanDecompress.cpp has its own Node
+namespace {
+
 class Node {
 	public:
 		int data;
@@ -30,6 +36,16 @@ class Compare{
 		}
 };
 
+void deleteTree(Node* root)
+{
+	if(root == nullptr) return;
+	deleteTree(root->left);
+	deleteTree(root->right);
+	delete root;
+}
+
+} // namespace
+
 void preorder(Node* root, map<char,string> &ans,string curr)
 {
 	if(root == nullptr) return;
@@ -43,9 +59,9 @@ void preorder(Node* root, map<char,string> &ans,string curr)
 	preorder(root->right,ans,curr+"1");
 }
 
-map<char,string> huffmanCode(string contents,map<char, int> freq)
+map<char,string> huffmanCode(const map<char, int>& freq)
 {
-	int n = contents.length();
+	if(freq.empty()) return map<char,string>();
 	priority_queue<Node*, vector<Node*>,Compare> pq;
 
 	for(auto &i:freq)
@@ -70,75 +86,284 @@ map<char,string> huffmanCode(string contents,map<char, int> freq)
 	Node* root = pq.top();
 	map<char,string> ans;
 	preorder(root,ans,"");
+	// The daemon builds tables for as long as it runs
+	deleteTree(root);
 	return ans;
 }
 
-void compress(const string& inFile,const string& outFile)
+// Inputs below this are encoded serially; thread startup would dominate
+static const size_t PARALLEL_MIN_BYTES = 1024 * 1024;
+// Longest code the 64-bit accumulator can take with 7 bits still pending
+static const size_t PARALLEL_MAX_CODE = 56;
+
+struct BoundaryByte {
+	size_t index;
+	unsigned char value;
+};
+
+/**
+ * Encodes text[begin,end) starting at bit offset startBit of out.
+ * Bytes owned entirely by this chunk are stored directly; a first or last
+ * byte shared with a neighbouring chunk is returned in edges to be OR-ed
+ * in afterwards, so threads never write the same byte.
+ */
+static void encodeChunk(const string& text,size_t begin,size_t end,size_t startBit,
+						const uint64_t* codeBits,const uint8_t* codeLen,
+						vector<char>& out,vector<BoundaryByte>& edges)
+{
+	size_t byteIndex = startBit / 8;
+	int phase = static_cast<int>(startBit % 8);
+	uint64_t acc = 0;
+	int pending = phase;	// the previous chunk's bits, seen as zeros here
+	for(size_t i = begin; i < end; i++) {
+		uint8_t c = static_cast<uint8_t>(text[i]);
+		acc = (acc << codeLen[c]) | codeBits[c];
+		pending += codeLen[c];
+		while(pending >= 8) {
+			pending -= 8;
+			unsigned char byte = static_cast<unsigned char>(acc >> pending);
+			if(phase != 0) {
+				edges.push_back({byteIndex, byte});
+				phase = 0;
+			} else {
+				out[byteIndex] = static_cast<char>(byte);
+			}
+			byteIndex++;
+		}
+	}
+	if(pending > 0) {
+		edges.push_back({byteIndex, static_cast<unsigned char>(acc << (8 - pending))});
+	}
+}
+
+/**
+ * Single-table parallel encode: per-chunk bit counts, an exclusive prefix
+ * sum for each chunk's exact output bit offset, then every thread encodes
+ * straight into the shared buffer. Only the boundary bytes are merged.
+ * With numThreads == 1 this is a plain flat-table encode into out.
+ */
+size_t encodeHuffman(const string& text,const map<char,string>& codes,
+					 int numThreads,vector<char>& out)
+{
+	uint64_t codeBits[256] = {};
+	uint8_t codeLen[256] = {};
+	size_t longestCode = 0;
+	for(auto &p : codes) {
+		uint8_t c = static_cast<uint8_t>(p.first);
+		codeLen[c] = static_cast<uint8_t>(p.second.length());
+		longestCode = max(longestCode, p.second.length());
+		for(char bit : p.second) codeBits[c] = (codeBits[c] << 1) | (bit == '1');
+	}
+	if(longestCode > PARALLEL_MAX_CODE) {
+		// Too long for the accumulator; go bit by bit
+		size_t bits = 0;
+		for(char c : text) bits += codes.at(c).length();
+		out.assign((bits + 7) / 8, 0);
+		size_t pos = 0;
+		for(char c : text) {
+			for(char bit : codes.at(c)) {
+				if(bit == '1') out[pos / 8] |= static_cast<char>(0x80 >> (pos % 8));
+				pos++;
+			}
+		}
+		return bits;
+	}
+
+	numThreads = max(numThreads, 1);
+	long chunks = numThreads > 1 ? static_cast<long>(numThreads) * 4 : 1;
+	size_t chunkSize = (text.size() + chunks - 1) / chunks;
+	vector<size_t> bitOffset(chunks + 1, 0);
+
+	#pragma omp parallel for num_threads(numThreads) schedule(static) if(numThreads > 1)
+	for(long k = 0; k < chunks; k++) {
+		size_t begin = min(text.size(), k * chunkSize);
+		size_t end = min(text.size(), begin + chunkSize);
+		size_t bits = 0;
+		for(size_t i = begin; i < end; i++) bits += codeLen[static_cast<uint8_t>(text[i])];
+		bitOffset[k + 1] = bits;
+	}
+	for(long k = 0; k < chunks; k++) bitOffset[k + 1] += bitOffset[k];
+	size_t compressedBits = bitOffset[chunks];
+
+	out.assign((compressedBits + 7) / 8, 0);
+	vector<vector<BoundaryByte>> edges(chunks);
+	#pragma omp parallel for num_threads(numThreads) schedule(static) if(numThreads > 1)
+	for(long k = 0; k < chunks; k++) {
+		size_t begin = min(text.size(), k * chunkSize);
+		size_t end = min(text.size(), begin + chunkSize);
+		encodeChunk(text, begin, end, bitOffset[k], codeBits, codeLen, out, edges[k]);
+	}
+	for(auto &chunkEdges : edges) {
+		for(auto &e : chunkEdges) out[e.index] |= static_cast<char>(e.value);
+	}
+	return compressedBits;
+}
+
+bool writeCodeMap(const string& mapFile,const map<char,string>& codes,const char* header)
+{
+	ofstream opfile(mapFile);
+	if(!opfile.is_open()) return false;
+	if(header) opfile << header << "\n";
+	for (auto &p : codes) {
+		if (p.first == '\n') opfile<< "\\n"; // special case for newline
+		else if (p.first == ' ') opfile << "[space]";
+		else opfile << p.first;
+		opfile << " " << p.second << "\n";
+	}
+	opfile.close();
+	return static_cast<bool>(opfile);
+}
+
+/**
+ * Packs the codes MSB-first into a staging buffer; each full buffer is
+ * handed to the async writer so encoding overlaps the device writes
+ */
+static void encodeSerial(const string& text,map<char,string>& codes,
+						 AsyncFileWriter& outputFile,size_t& compressedBits)
+{
+	vector<char> staging;
+	staging.reserve(64 * 1024);
+	unsigned char byteValue = 0;
+	int bitCount = 0;
+	for(char c : text) {
+		for(char bit : codes[c]) {
+			byteValue = (byteValue << 1) | (bit == '1');
+			if(++bitCount == 8) {
+				staging.push_back(static_cast<char>(byteValue));
+				byteValue = 0;
+				bitCount = 0;
+				if(staging.size() == staging.capacity()) {
+					outputFile.write(staging.data(), staging.size());
+					staging.clear();
+				}
+			}
+		}
+		compressedBits += codes[c].length();
+	}
+	
+	// Pad the last byte with zeros
+	if(bitCount > 0) {
+		staging.push_back(static_cast<char>(byteValue << (8 - bitCount)));
+	}
+	outputFile.write(staging.data(), staging.size());
+}
+
+bool compress(const string& inFile,const string& outFile,int numThreads)
 {
-		ifstream inputFile(inFile);
-		if(!inputFile.is_open())
+		string file_contents;
+		if(!readFileAsync(inFile,file_contents))
 		{
 			cerr<<"Error opening the file:"<<inFile<<endl;
-			return;
+			return false;
 		}
-		std::stringstream buffer;
-		buffer<<inputFile.rdbuf();
-		string file_contents = buffer.str();
-		inputFile.close();
 		
-		auto frequencyTable = calculateFrequencies(file_contents);
-		map<char,string> result = huffmanCode(file_contents,frequencyTable);	
+		if(numThreads <= 0) numThreads = omp_get_max_threads();
+		auto frequencyTable = calculateFrequencies(file_contents, numThreads);
+		map<char,string> result = huffmanCode(frequencyTable);	
 
-		// Build the compressed bit string
-		string compressedBits = "";
-		for(char c : file_contents) {
-			compressedBits += result[c];
+		AsyncFileWriter outputFile(outFile);
+		if(!outputFile.isOpen())
+		{
+			cout<<"Error in creating/writing the file\n";
+			return false;
+		}
+
+		size_t compressedBits = 0;
+		if(numThreads > 1 && file_contents.size() >= PARALLEL_MIN_BYTES)
+		{
+			vector<char> encoded;
+			compressedBits = encodeHuffman(file_contents, result, numThreads, encoded);
+			outputFile.write(encoded.data(), encoded.size());
+		}
+		else
+		{
+			numThreads = 1;
+			encodeSerial(file_contents, result, outputFile, compressedBits);
 		}
 		
 		cout << "Original size: " << file_contents.length() << " bytes" << endl;
-		cout << "Compressed bits: " << compressedBits.length() << " bits" << endl;
+		cout << "Compressed bits: " << compressedBits << " bits (" << numThreads << (numThreads == 1 ? " thread)" : " threads)") << endl;
 		
-		// Pad the bit string to make it divisible by 8
-		while(compressedBits.length() % 8 != 0) {
-			compressedBits += "0";
-		}
-		
-		// Convert bit string to bytes and write to file
-		ofstream outputFile(outFile, ios::binary);
-		if(outputFile.is_open())
+		if(!outputFile.close())
 		{
-			for(size_t i = 0; i < compressedBits.length(); i += 8) {
-				string byte = compressedBits.substr(i, 8);
-				char byteValue = 0;
-				for(int j = 0; j < 8; j++) {
-					if(byte[j] == '1') {
-						byteValue |= (1 << (7 - j));
-					}
-				}
-				outputFile.write(&byteValue, 1);
-			}
-			outputFile.close();
-			cout << "Compressed to " << compressedBits.length() / 8 << " bytes" << endl;
-		}
-		else{
 			cout<<"Error in creating/writing the file\n";
-			return;
+			return false;
 		}
+		cout << "Compressed to " << (compressedBits + 7) / 8 << " bytes" << endl;
 
 		// Write map file with consistent format
-		ofstream opfile(outFile+".map");
-		if(opfile.is_open())
+		if(!writeCodeMap(outFile+".map",result))
 		{
-			for (auto &p : result) {
-        		if (p.first == '\n') opfile<< "\\n"; // special case for newline
-        		else if (p.first == ' ') opfile << "[space]";
-        		else opfile << p.first;
-        		opfile << " " << p.second << "\n";
-			}
-			opfile.close();
-			cout << "Map file created with " << result.size() << " entries" << endl;
-		}
-		else {
 			cout << "Error creating map file\n";
+			return false;
 		}
+		cout << "Map file created with " << result.size() << " entries" << endl;
+		return true;
+}
+
+vector<uint8_t> encodeDedup(const string& text,int numThreads,map<char,string>& codes,
+							size_t* compressedBits,DedupStats* stats)
+{
+	// Codes are built from the unique bytes only, so repeated regions don't
+	// skew the frequencies
+	DedupParams params;
+	params.threads = numThreads;
+	return dedup_encode_stream(
+		reinterpret_cast<const uint8_t*>(text.data()), text.size(),
+		[&](const uint8_t* data, size_t size) {
+			string unique(reinterpret_cast<const char*>(data), size);
+			codes = huffmanCode(calculateFrequencies(unique, numThreads));
+			// A lone symbol comes out of the tree with an empty code, so nothing
+			// would be written for it. The container records the real size, so
+			// a 1-bit code is safe here: padding bits past it are dropped.
+			if(codes.size() == 1) codes.begin()->second = "0";
+			vector<char> encoded;
+			size_t bits = encodeHuffman(unique, codes, size >= PARALLEL_MIN_BYTES ? numThreads : 1, encoded);
+			if(compressedBits) *compressedBits = bits;
+			return vector<uint8_t>(encoded.begin(), encoded.end());
+		},
+		params, stats);
+}
+
+bool compressDedup(const string& inFile,const string& outFile,int numThreads)
+{
+	string file_contents;
+	if(!readFileAsync(inFile,file_contents))
+	{
+		cerr<<"Error opening the file:"<<inFile<<endl;
+		return false;
+	}
+	if(numThreads <= 0) numThreads = omp_get_max_threads();
+
+	map<char,string> result;
+	size_t compressedBits = 0;
+	DedupStats stats;
+	vector<uint8_t> stream = encodeDedup(file_contents, numThreads, result, &compressedBits, &stats);
+
+	cout << "Original size: " << file_contents.length() << " bytes" << endl;
+	cout << "Chunks: " << stats.chunks << " (" << stats.uniqueChunks << " unique), "
+		 << stats.duplicateBytes << " duplicate bytes stored as references" << endl;
+	cout << "Compressed bits: " << compressedBits << " bits for " << stats.uniqueBytes << " unique bytes" << endl;
+
+	AsyncFileWriter outputFile(outFile);
+	if(!outputFile.isOpen())
+	{
+		cout<<"Error in creating/writing the file\n";
+		return false;
+	}
+	outputFile.write(stream.data(), stream.size());
+	if(!outputFile.close())
+	{
+		cout<<"Error in creating/writing the file\n";
+		return false;
+	}
+	cout << "Compressed to " << stream.size() << " bytes" << endl;
+
+	if(!writeCodeMap(outFile+".map",result,HUFFMAN_DEDUP_MAGIC))
+	{
+		cout << "Error creating map file\n";
+		return false;
+	}
+	cout << "Map file created with " << result.size() << " entries" << endl;
+	return true;
 }
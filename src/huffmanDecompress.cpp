@@ -1,4 +1,10 @@
 #include "huffmanDecompress.h"
+#include "asyncIO.h"
+#include "simdKernels.h"
+#include "huffmanTokens.h"
+#include "huffmanCompress.h"
+#include "dedup.h"
+#include <cstring>
 #include <vector>
 #include <unordered_map>
 #include <fstream>
@@ -6,12 +12,17 @@
 #include <iostream>
 using namespace std;
 
+namespace {
+
 struct Node {
     char data;
+    bool leaf;
     Node *left, *right;
-    Node(char c = '\0') : data(c), left(nullptr), right(nullptr) {}
+    Node(char c = '\0') : data(c), leaf(false), left(nullptr), right(nullptr) {}
 };
 
+} // namespace
+
 Node* buildHuffmanTree(const unordered_map<string, char>& codeMap) {
     Node* root = new Node();
     for (const auto& pair : codeMap) {
@@ -30,10 +41,34 @@ Node* buildHuffmanTree(const unordered_map<string, char>& codeMap) {
             }
         }
         current->data = ch;
+        current->leaf = true;
     }
     return root;
 }
 
+// Flat table over the next tableBits bits for every code that fits in it
+vector<HuffDecodeEntry> buildDecodeTable(const unordered_map<string, char>& codeMap, int& tableBits) {
+    size_t longest = 1;
+    for (const auto& pair : codeMap) longest = max(longest, pair.first.length());
+    tableBits = static_cast<int>(min<size_t>(longest, 12));
+
+    vector<HuffDecodeEntry> table(size_t(1) << tableBits, HuffDecodeEntry{0, 0});
+    for (const auto& pair : codeMap) {
+        const string& code = pair.first;
+        int len = static_cast<int>(code.length());
+        if (len == 0 || len > tableBits) continue;
+        size_t prefix = 0;
+        for (char bit : code) prefix = (prefix << 1) | (bit == '1');
+        size_t first = prefix << (tableBits - len);
+        size_t last = first + (size_t(1) << (tableBits - len));
+        for (size_t i = first; i < last; i++) {
+            table[i].symbol = static_cast<uint8_t>(pair.second);
+            table[i].length = static_cast<uint8_t>(len);
+        }
+    }
+    return table;
+}
+
 void deleteTree(Node* root) {
     if (root) {
         deleteTree(root->left);
@@ -42,23 +77,9 @@ void deleteTree(Node* root) {
     }
 }
 
-void decompress(const std::string& input,const std::string& output)
+// Reads "<char> <code>" lines in the legacy map format
+static void readCodeMap(istream& mapFile, unordered_map<string, char>& codeMap)
 {
-    ifstream inFile(input, ios::binary);
-    if(!inFile.is_open())
-    {
-        cerr<<"Error opening the file "<<input<<endl;
-        return;
-    }
-    ifstream mapFile(input+".map");
-    if(!mapFile.is_open())
-    {
-        cerr<<"Error opening the map file "<<input<<".map"<<endl;
-        inFile.close();
-        return;
-    }
-
-    unordered_map<string, char> codeMap;
     string line;
     while(getline(mapFile,line))
     {
@@ -78,68 +99,164 @@ void decompress(const std::string& input,const std::string& output)
             codeMap[code] = ch;
         }
     }
-    mapFile.close();
-    
-    cout << "Loaded " << codeMap.size() << " codes from map file" << endl;
+}
 
-    Node* root = buildHuffmanTree(codeMap);
+struct HuffmanDecoder {
+    bool dedup = false;
+    // Byte codes, for plain and --dedup maps
+    Node* root = nullptr;
+    vector<HuffDecodeEntry> table;
+    int tableBits = 0;
+    // --words / --bigrams maps
+    shared_ptr<const TokenDecoder> tokens;
 
-    stringstream buffer;
-    buffer << inFile.rdbuf();
-    string compressedData = buffer.str();
-    inFile.close();
-    
-    cout << "Read " << compressedData.length() << " bytes of compressed data" << endl;
+    ~HuffmanDecoder() { deleteTree(root); }
+};
 
-    //convert compressed data to bit string
-    string bitString="";
-    for(char byte:compressedData)
+shared_ptr<const HuffmanDecoder> loadDecoder(const std::string& mapText)
+{
+    auto decoder = make_shared<HuffmanDecoder>();
+    if(mapText.compare(0, strlen(HUFFMAN_TOKENS_MAGIC), HUFFMAN_TOKENS_MAGIC) == 0)
     {
-        for(int i=7;i>=0;--i)
-        {
-            bitString += ((byte>>i)&1) ? '1' : '0';
-        }
+        decoder->tokens = loadTokenDecoder(mapText);
+        if(!decoder->tokens) return nullptr;
+        return decoder;
     }
-    
-    cout << "Converted to " << bitString.length() << " bits" << endl;
-
-    // Decompression logic with null checks
-    string decodedString = "";
-    Node* current = root;
-    for (char bit : bitString) {
-        if (bit == '0') {
-            current = current->left;
-        } else {
-            current = current->right;
+
+    istringstream mapFile(mapText);
+    string header;
+    decoder->dedup = mapText.compare(0, mapText.find('\n'), HUFFMAN_DEDUP_MAGIC) == 0;
+    if(decoder->dedup) getline(mapFile, header);
+
+    unordered_map<string, char> codeMap;
+    readCodeMap(mapFile, codeMap);
+    cout << "Loaded " << codeMap.size() << " codes from map file" << endl;
+
+    decoder->root = buildHuffmanTree(codeMap);
+    decoder->table = buildDecodeTable(codeMap, decoder->tableBits);
+    return decoder;
+}
+
+// Decodes a whole MSB-first bitstream, padding bits included
+static bool decodeBits(const uint8_t* bytes, size_t totalBytes,
+                       const HuffmanDecoder& decoder, vector<uint8_t>& decoded)
+{
+    size_t totalBits = totalBytes * 8;
+
+    // Table-driven decode through the dispatched kernel; codes longer than
+    // the table and the last few bytes fall back to walking the tree
+    const KernelTable& k = kernels();
+
+    decoded.clear();
+    size_t produced = 0;
+    size_t bitPos = 0;
+    while (bitPos < totalBits) {
+        if (decoded.size() < produced + 4096) {
+            decoded.resize(2 * (produced + 4096));
         }
-        
-        // Check if current is null or if we reached a leaf node
+        size_t room = decoded.size() - produced;
+        size_t n = k.huffmanDecode(bytes, totalBytes, &bitPos, decoder.table.data(), decoder.tableBits,
+                                   &decoded[produced], room);
+        produced += n;
+        if (n == room) continue;
+
+        Node* current = decoder.root;
+        do {
+            int bit = (bytes[bitPos >> 3] >> (7 - (bitPos & 7))) & 1;
+            current = bit ? current->right : current->left;
+            bitPos++;
+        } while (current != nullptr && !current->leaf && bitPos < totalBits);
+
         if (current == nullptr) {
             cerr << "Error: Invalid bit sequence encountered" << endl;
-            deleteTree(root);
-            return;
+            return false;
         }
-        
-        if (current->data != '\0') {
-            decodedString += current->data;
-            current = root;
+        if (current->leaf) {
+            decoded[produced++] = static_cast<uint8_t>(current->data);
         }
     }
-    
-    cout << "Decoded " << decodedString.length() << " characters" << endl;
+    decoded.resize(produced);
+    return true;
+}
+
+bool decodeBuffer(const HuffmanDecoder& decoder, const uint8_t* data, size_t size,
+                  std::vector<uint8_t>& output)
+{
+    if(decoder.tokens)
+    {
+        return decodeTokens(*decoder.tokens, data, size, output);
+    }
+    if(!decoder.dedup)
+    {
+        return decodeBits(data, size, decoder, output);
+    }
 
-    // Write the decompressed data to the output file
-    ofstream outFile(output);
-    if (!outFile.is_open()) {
+    // Only the unique chunks were coded; the chunk table rebuilds the rest
+    bool ok = dedup_decode_stream(data, size,
+        [&](const uint8_t* payload, size_t payloadSize, size_t, vector<uint8_t>& unique) {
+            return decodeBits(payload, payloadSize, decoder, unique);
+        },
+        output);
+    if(!ok)
+    {
+        cerr<<"Error: not a valid dedup stream"<<endl;
+    }
+    return ok;
+}
+
+static bool writeDecoded(const string& output, const void* data, size_t size)
+{
+    AsyncFileWriter outFile(output);
+    if (!outFile.isOpen()) {
         cerr << "Error opening the output file " << output << endl;
-        deleteTree(root);
-        return;
+        return false;
+    }
+    outFile.write(data, size);
+    if (!outFile.close()) {
+        cerr << "Error writing the output file " << output << endl;
+        return false;
+    }
+    return true;
+}
+
+bool decompress(const std::string& input,const std::string& output)
+{
+    string mapText;
+    if(!readFileAsync(input+".map", mapText))
+    {
+        cerr<<"Error opening the map file "<<input<<".map"<<endl;
+        return false;
+    }
+    shared_ptr<const HuffmanDecoder> decoder = loadDecoder(mapText);
+    if(!decoder)
+    {
+        return false;
+    }
+
+    string compressedData;
+    if(!readFileAsync(input, compressedData))
+    {
+        cerr<<"Error opening the file "<<input<<endl;
+        return false;
     }
-    outFile << decodedString;
-    outFile.close();
     
-    cout << "Successfully decompressed to " << output << endl;
+    cout << "Read " << compressedData.length() << " bytes of compressed data" << endl;
+    cout << "Converted to " << compressedData.length() * 8 << " bits" << endl;
 
-    // Clean up properly
-    deleteTree(root);
-}
\ No newline at end of file
+    vector<uint8_t> decoded;
+    if(!decodeBuffer(*decoder, reinterpret_cast<const uint8_t*>(compressedData.data()),
+                     compressedData.length(), decoded))
+    {
+        return false;
+    }
+    
+    cout << "Decoded " << decoded.size() << " characters" << endl;
+
+    if(!writeDecoded(output, decoded.data(), decoded.size()))
+    {
+        return false;
+    }
+    
+    cout << "Successfully decompressed to " << output << endl;
+    return true;
+}
@@ -0,0 +1,486 @@
+#include "../include/huffmanTokens.h"
+#include "../include/asyncIO.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Symbols 0..255 are raw bytes; tokens are numbered from 256
+static const int BYTE_SYMBOLS = 256;
+static const size_t MAX_TOKENS = 4096;
+static const uint64_t MIN_TOKEN_COUNT = 4;
+static const size_t MAX_WORD_LENGTH = 64;
+// Keeps every code short enough for the 64-bit bit writer
+static const int MAX_CODE_LENGTH = 56;
+static const int DECODE_TABLE_BITS = 12;
+
+namespace {
+
+struct Alphabet {
+    // Flat token storage: symbol s spans bytes[offset[s], offset[s] + length[s])
+    string bytes;
+    vector<uint32_t> offset;
+    vector<uint16_t> length;
+
+    void add(const char* data, size_t n) {
+        offset.push_back(static_cast<uint32_t>(bytes.size()));
+        length.push_back(static_cast<uint16_t>(n));
+        bytes.append(data, n);
+    }
+    size_t size() const { return offset.size(); }
+};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// A word token is a run of non-whitespace plus one trailing space if present
+size_t wordLength(const string& text, size_t i) {
+    size_t j = i;
+    while (j < text.size() && !isSpace(text[j]) && j - i < MAX_WORD_LENGTH) j++;
+    if (j < text.size() && text[j] == ' ' && j > i) j++;
+    return j - i;
+}
+
+Alphabet byteAlphabet() {
+    Alphabet alphabet;
+    for (int b = 0; b < BYTE_SYMBOLS; b++) {
+        char c = static_cast<char>(b);
+        alphabet.add(&c, 1);
+    }
+    return alphabet;
+}
+
+// Keeps the candidates that save the most bytes, most valuable first
+template <typename Key>
+vector<Key> pickTokens(const vector<pair<Key, uint64_t>>& candidates,
+                       size_t (*len)(const Key&)) {
+    vector<pair<Key, uint64_t>> kept;
+    for (const auto& c : candidates) {
+        if (c.second >= MIN_TOKEN_COUNT && len(c.first) > 1) kept.push_back(c);
+    }
+    sort(kept.begin(), kept.end(), [&](const pair<Key, uint64_t>& a, const pair<Key, uint64_t>& b) {
+        uint64_t va = a.second * (len(a.first) - 1), vb = b.second * (len(b.first) - 1);
+        return va != vb ? va > vb : a.first < b.first;
+    });
+    if (kept.size() > MAX_TOKENS) kept.resize(MAX_TOKENS);
+    vector<Key> tokens;
+    for (const auto& k : kept) tokens.push_back(k.first);
+    return tokens;
+}
+
+size_t stringLength(const string& s) { return s.size(); }
+size_t bigramLength(const uint16_t&) { return 2; }
+
+/**
+ * Splits text into symbols: dictionary tokens where they match, byte
+ * escapes everywhere else.
+ */
+vector<uint32_t> tokenize(const string& text, TokenMode mode, Alphabet& alphabet) {
+    vector<uint32_t> symbols;
+    symbols.reserve(text.size() / 2);
+
+    if (mode == TokenMode::Bigrams) {
+        vector<uint64_t> counts(65536, 0);
+        for (size_t i = 0; i + 1 < text.size(); i++) {
+            counts[static_cast<uint8_t>(text[i]) << 8 | static_cast<uint8_t>(text[i + 1])]++;
+        }
+        vector<pair<uint16_t, uint64_t>> candidates;
+        for (uint32_t b = 0; b < 65536; b++) {
+            if (counts[b]) candidates.push_back({static_cast<uint16_t>(b), counts[b]});
+        }
+        vector<int32_t> id(65536, -1);
+        for (uint16_t b : pickTokens(candidates, bigramLength)) {
+            char pairBytes[2] = {static_cast<char>(b >> 8), static_cast<char>(b & 0xFF)};
+            id[b] = static_cast<int32_t>(alphabet.size());
+            alphabet.add(pairBytes, 2);
+        }
+        size_t i = 0;
+        while (i < text.size()) {
+            if (i + 1 < text.size()) {
+                int32_t s = id[static_cast<uint8_t>(text[i]) << 8 | static_cast<uint8_t>(text[i + 1])];
+                if (s >= 0) {
+                    symbols.push_back(static_cast<uint32_t>(s));
+                    i += 2;
+                    continue;
+                }
+            }
+            symbols.push_back(static_cast<uint8_t>(text[i++]));
+        }
+        return symbols;
+    }
+
+    unordered_map<string, uint64_t> counts;
+    for (size_t i = 0; i < text.size();) {
+        size_t n = wordLength(text, i);
+        if (n == 0) { i++; continue; }
+        counts[text.substr(i, n)]++;
+        i += n;
+    }
+    vector<pair<string, uint64_t>> candidates(counts.begin(), counts.end());
+    unordered_map<string, uint32_t> id;
+    for (const string& w : pickTokens(candidates, stringLength)) {
+        id[w] = static_cast<uint32_t>(alphabet.size());
+        alphabet.add(w.data(), w.size());
+    }
+    for (size_t i = 0; i < text.size();) {
+        size_t n = wordLength(text, i);
+        if (n == 0) {
+            symbols.push_back(static_cast<uint8_t>(text[i++]));
+            continue;
+        }
+        auto it = id.find(text.substr(i, n));
+        if (it != id.end()) {
+            symbols.push_back(it->second);
+        } else {
+            for (size_t j = i; j < i + n; j++) symbols.push_back(static_cast<uint8_t>(text[j]));
+        }
+        i += n;
+    }
+    return symbols;
+}
+
+/**
+ * Huffman code lengths over symbol ids (0 for unused symbols). Counts are
+ * halved until the longest code fits in MAX_CODE_LENGTH bits.
+ */
+vector<uint8_t> codeLengths(vector<uint64_t> freq) {
+    size_t n = freq.size();
+    vector<uint8_t> lengths(n, 0);
+    for (;;) {
+        typedef pair<uint64_t, uint32_t> Item;
+        priority_queue<Item, vector<Item>, greater<Item>> pq;
+        vector<uint32_t> parent(n, 0);
+        for (uint32_t s = 0; s < n; s++) {
+            if (freq[s]) pq.push({freq[s], s});
+        }
+        if (pq.empty()) return lengths;
+        if (pq.size() == 1) {
+            lengths[pq.top().second] = 1;
+            return lengths;
+        }
+        while (pq.size() > 1) {
+            Item a = pq.top(); pq.pop();
+            Item b = pq.top(); pq.pop();
+            uint32_t node = static_cast<uint32_t>(parent.size());
+            parent.push_back(0);
+            parent[a.second] = node;
+            parent[b.second] = node;
+            pq.push({a.first + b.first, node});
+        }
+        uint32_t root = static_cast<uint32_t>(parent.size() - 1);
+        // Parents always have higher indices, so depths resolve top-down
+        vector<uint8_t> depth(parent.size(), 0);
+        int longest = 0;
+        for (uint32_t v = root; v-- > 0;) {
+            depth[v] = static_cast<uint8_t>(min(depth[parent[v]] + 1, 255));
+        }
+        for (uint32_t s = 0; s < n; s++) {
+            lengths[s] = freq[s] ? depth[s] : 0;
+            longest = max(longest, static_cast<int>(lengths[s]));
+        }
+        if (longest <= MAX_CODE_LENGTH) return lengths;
+        for (auto& f : freq) {
+            if (f) f = (f + 1) / 2;
+        }
+    }
+}
+
+// Canonical codes: ordered by (length, symbol), consecutive within a length
+vector<uint64_t> canonicalCodes(const vector<uint8_t>& lengths) {
+    vector<uint32_t> order;
+    for (uint32_t s = 0; s < lengths.size(); s++) {
+        if (lengths[s]) order.push_back(s);
+    }
+    stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return lengths[a] < lengths[b];
+    });
+    vector<uint64_t> codes(lengths.size(), 0);
+    uint64_t code = 0;
+    int prevLen = 0;
+    for (uint32_t s : order) {
+        code <<= (lengths[s] - prevLen);
+        codes[s] = code++;
+        prevLen = lengths[s];
+    }
+    return codes;
+}
+
+string toHex(const char* data, size_t n) {
+    static const char* digits = "0123456789abcdef";
+    string hex;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b = static_cast<uint8_t>(data[i]);
+        hex += digits[b >> 4];
+        hex += digits[b & 0xF];
+    }
+    return hex;
+}
+
+bool fromHex(const string& hex, string& out) {
+    if (hex.empty() || hex.size() % 2) return false;
+    out.clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int v = 0;
+        for (size_t j = i; j < i + 2; j++) {
+            char c = hex[j];
+            int d = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+            if (d < 0) return false;
+            v = v * 16 + d;
+        }
+        out += static_cast<char>(v);
+    }
+    return true;
+}
+
+} // namespace
+
+
+// ============================================================================
+// COMPRESSION
+// ============================================================================
+
+TokenStats encodeTokens(const string& text, TokenMode mode, vector<char>& out, string& mapText)
+{
+    Alphabet alphabet = byteAlphabet();
+    vector<uint32_t> symbols = tokenize(text, mode, alphabet);
+
+    // Hash-free from here on: flat frequency, length and code arrays by id
+    vector<uint64_t> freq(alphabet.size(), 0);
+    for (uint32_t s : symbols) freq[s]++;
+    vector<uint8_t> fullLengths = codeLengths(freq);
+
+    // Only used symbols go into the map; renumber them densely in id order
+    vector<uint32_t> used;
+    vector<uint32_t> denseId(alphabet.size(), 0);
+    for (uint32_t s = 0; s < alphabet.size(); s++) {
+        if (fullLengths[s]) {
+            denseId[s] = static_cast<uint32_t>(used.size());
+            used.push_back(s);
+        }
+    }
+    vector<uint8_t> lengths(used.size());
+    for (size_t i = 0; i < used.size(); i++) lengths[i] = fullLengths[used[i]];
+    vector<uint64_t> codes = canonicalCodes(lengths);
+
+    TokenStats stats;
+    stats.symbols = symbols.size();
+    stats.tokens = alphabet.size() - BYTE_SYMBOLS;
+    stats.codes = used.size();
+    for (uint32_t s : symbols) stats.compressedBits += lengths[denseId[s]];
+
+    out.assign((stats.compressedBits + 7) / 8, 0);
+    uint64_t acc = 0;
+    int pending = 0;
+    size_t byteIndex = 0;
+    for (uint32_t s : symbols) {
+        uint32_t d = denseId[s];
+        acc = (acc << lengths[d]) | codes[d];
+        pending += lengths[d];
+        while (pending >= 8) {
+            pending -= 8;
+            out[byteIndex++] = static_cast<char>(acc >> pending);
+        }
+    }
+    if (pending > 0) {
+        out[byteIndex] = static_cast<char>(acc << (8 - pending));
+    }
+
+    ostringstream map;
+    map << HUFFMAN_TOKENS_MAGIC << " " << (mode == TokenMode::Words ? "words" : "bigrams")
+        << " " << text.length() << " " << used.size() << "\n";
+    for (size_t i = 0; i < used.size(); i++) {
+        uint32_t s = used[i];
+        map << toHex(alphabet.bytes.data() + alphabet.offset[s], alphabet.length[s])
+            << " " << static_cast<int>(lengths[i]) << "\n";
+    }
+    mapText = map.str();
+    return stats;
+}
+
+bool compressTokens(const string& inFile, const string& outFile, TokenMode mode)
+{
+    string text;
+    if (!readFileAsync(inFile, text)) {
+        cerr << "Error opening the file:" << inFile << endl;
+        return false;
+    }
+
+    vector<char> encoded;
+    string mapText;
+    TokenStats stats = encodeTokens(text, mode, encoded, mapText);
+
+    AsyncFileWriter outputFile(outFile);
+    if (!outputFile.isOpen()) {
+        cout << "Error in creating/writing the file\n";
+        return false;
+    }
+    outputFile.write(encoded.data(), encoded.size());
+    if (!outputFile.close()) {
+        cout << "Error in creating/writing the file\n";
+        return false;
+    }
+
+    cout << "Original size: " << text.length() << " bytes" << endl;
+    cout << "Symbols: " << stats.symbols << " (" << stats.tokens
+         << " " << (mode == TokenMode::Words ? "word" : "bigram") << " tokens)" << endl;
+    cout << "Compressed bits: " << stats.compressedBits << " bits" << endl;
+    cout << "Compressed to " << encoded.size() << " bytes" << endl;
+
+    ofstream opfile(outFile + ".map");
+    if (!opfile.is_open() || !(opfile << mapText)) {
+        cout << "Error creating map file\n";
+        return false;
+    }
+    opfile.close();
+    if (!opfile) {
+        cout << "Error creating map file\n";
+        return false;
+    }
+    cout << "Map file created with " << stats.codes << " entries" << endl;
+    return true;
+}
+
+// ============================================================================
+// DECOMPRESSION
+// ============================================================================
+
+struct TokenDecoder {
+    uint64_t originalSize = 0;
+    Alphabet alphabet;
+    size_t longestToken = 1;
+    // Lookup table for codes up to DECODE_TABLE_BITS; longer ones are
+    // resolved canonically one length at a time
+    struct Entry { uint32_t symbol; uint8_t length; };
+    vector<Entry> table;
+    int tableBits = 0;
+    int maxLen = 0;
+    vector<uint64_t> firstCode;
+    vector<uint32_t> firstIndex, countAt, sorted;
+};
+
+shared_ptr<const TokenDecoder> loadTokenDecoder(const string& mapText)
+{
+    istringstream mapFile(mapText);
+    string magic, modeName;
+    size_t symbolCount = 0;
+    auto decoder = make_shared<TokenDecoder>();
+    if (!(mapFile >> magic >> modeName >> decoder->originalSize >> symbolCount) ||
+        magic != HUFFMAN_TOKENS_MAGIC) {
+        cerr << "Error: malformed token map" << endl;
+        return nullptr;
+    }
+
+    Alphabet& alphabet = decoder->alphabet;
+    vector<uint8_t> lengths;
+    // Kraft sum in units of 2^-MAX_CODE_LENGTH; over 1 means the lengths
+    // can't form a prefix code and canonical codes would overrun the table
+    const uint64_t kraftLimit = uint64_t(1) << MAX_CODE_LENGTH;
+    uint64_t kraft = 0;
+    for (size_t i = 0; i < symbolCount; i++) {
+        string hex, token;
+        int len;
+        if (!(mapFile >> hex >> len) || !fromHex(hex, token) || len < 1 || len > MAX_CODE_LENGTH ||
+            (kraft += kraftLimit >> len) > kraftLimit) {
+            cerr << "Error: malformed token map" << endl;
+            return nullptr;
+        }
+        alphabet.add(token.data(), token.size());
+        lengths.push_back(static_cast<uint8_t>(len));
+        decoder->longestToken = max(decoder->longestToken, token.size());
+    }
+    cout << "Loaded " << symbolCount << " " << modeName << " symbols from map file" << endl;
+
+    vector<uint64_t> codes = canonicalCodes(lengths);
+    int maxLen = 0;
+    for (uint8_t l : lengths) maxLen = max(maxLen, static_cast<int>(l));
+    int tableBits = min(max(maxLen, 1), DECODE_TABLE_BITS);
+    decoder->maxLen = maxLen;
+    decoder->tableBits = tableBits;
+    decoder->table.assign(size_t(1) << tableBits, TokenDecoder::Entry{0, 0});
+    decoder->firstCode.assign(MAX_CODE_LENGTH + 2, 0);
+    decoder->firstIndex.assign(MAX_CODE_LENGTH + 2, 0);
+    decoder->countAt.assign(MAX_CODE_LENGTH + 2, 0);
+    for (int len = 1; len <= maxLen; len++) {
+        decoder->firstIndex[len] = static_cast<uint32_t>(decoder->sorted.size());
+        for (uint32_t s = 0; s < lengths.size(); s++) {
+            if (lengths[s] != len) continue;
+            if (decoder->countAt[len]++ == 0) decoder->firstCode[len] = codes[s];
+            decoder->sorted.push_back(s);
+            if (len <= tableBits) {
+                size_t first = codes[s] << (tableBits - len);
+                for (size_t i = first; i < first + (size_t(1) << (tableBits - len)); i++) {
+                    decoder->table[i] = TokenDecoder::Entry{s, static_cast<uint8_t>(len)};
+                }
+            }
+        }
+    }
+    return decoder;
+}
+
+bool decodeTokens(const TokenDecoder& decoder, const uint8_t* bytes, size_t size, vector<uint8_t>& decoded)
+{
+    const uint64_t originalSize = decoder.originalSize;
+    const Alphabet& alphabet = decoder.alphabet;
+    const int tableBits = decoder.tableBits;
+    size_t totalBits = size * 8;
+    // Every code is at least a bit long, so the map can't claim more output
+    // than the stream could hold
+    if (originalSize > totalBits * decoder.longestToken) {
+        cerr << "Error: Invalid bit sequence encountered" << endl;
+        return false;
+    }
+
+    decoded.resize(originalSize);
+    size_t produced = 0;
+    size_t bitPos = 0;
+    while (produced < originalSize) {
+        // Zeros past the end keep the window read in bounds on the last bytes
+        size_t at = bitPos >> 3;
+        uint64_t window = 0;
+        if (at + 8 <= size) {
+            for (int b = 0; b < 8; b++) window = (window << 8) | bytes[at + b];
+        } else {
+            for (size_t b = 0; b < 8; b++) window = (window << 8) | (at + b < size ? bytes[at + b] : 0);
+        }
+        window <<= (bitPos & 7);
+
+        uint32_t symbol = 0;
+        int len = 0;
+        const TokenDecoder::Entry& e = decoder.table[window >> (64 - tableBits)];
+        if (e.length) {
+            symbol = e.symbol;
+            len = e.length;
+        } else {
+            for (int l = tableBits + 1; l <= decoder.maxLen && l <= 57; l++) {
+                uint64_t code = window >> (64 - l);
+                if (decoder.countAt[l] && code >= decoder.firstCode[l] &&
+                    code - decoder.firstCode[l] < decoder.countAt[l]) {
+                    symbol = decoder.sorted[decoder.firstIndex[l] + (code - decoder.firstCode[l])];
+                    len = l;
+                    break;
+                }
+            }
+        }
+        if (len == 0 || bitPos + len > totalBits) {
+            cerr << "Error: Invalid bit sequence encountered" << endl;
+            return false;
+        }
+        bitPos += len;
+
+        // One lookup emits the whole token
+        size_t n = alphabet.length[symbol];
+        if (produced + n > originalSize) {
+            cerr << "Error: Invalid bit sequence encountered" << endl;
+            return false;
+        }
+        memcpy(&decoded[produced], alphabet.bytes.data() + alphabet.offset[symbol], n);
+        produced += n;
+    }
+    return true;
+}
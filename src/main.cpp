@@ -1,28 +1,23 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <cstdlib>
 #include "../include/huffmanCompress.h"
 #include "../include/huffmanDecompress.h"
+#include "../include/huffmanTokens.h"
+#include "../include/daemon.h"
 using namespace std;
 
-class Node {
-	public:
-		int data;
-		Node *left, *right;
-		Node(int x)
-		{
-			data = x;
-			left = nullptr;
-			right = nullptr;
-		}
-};
-
 int main(int argc, char* argv[])
 {
     if(argc < 2)
     {
         cout<<"Usage: \n";
-        cout<<" compress <input_file> <output_file>\n";
+        cout<<" compress <input_file> <output_file> [--words|--bigrams|--dedup] [--threads N]\n";
         cout<<" decompress <input_file> <output_file>\n";
+        cout<<" daemon <socket_path> [--workers N] [--batch N]\n";
+        cout<<" client <socket_path> compress|decompress|stats|shutdown [args...]\n";
+        cout<<" client <socket_path> -   (one request per stdin line)\n";
         return 1;
     }
 
@@ -37,9 +32,32 @@ int main(int argc, char* argv[])
         }
         string inputFile = argv[2];
         string outputFile = argv[3];
+        string mode;
+        int threads = 0;
+        for(int i = 4; i < argc; i++)
+        {
+            string option = argv[i];
+            if(option == "--threads" && i + 1 < argc)
+                threads = atoi(argv[++i]);
+            else if(option == "--words" || option == "--bigrams" || option == "--dedup")
+                mode = option;
+            else
+            {
+                cout<<"Unknown option: "<<option<<"\n";
+                return 1;
+            }
+        }
 
-
-        compress(inputFile,outputFile);
+        bool ok;
+        if(mode == "--words")
+            ok = compressTokens(inputFile,outputFile,TokenMode::Words);
+        else if(mode == "--bigrams")
+            ok = compressTokens(inputFile,outputFile,TokenMode::Bigrams);
+        else if(mode == "--dedup")
+            ok = compressDedup(inputFile,outputFile,threads);
+        else
+            ok = compress(inputFile,outputFile,threads);
+        return ok ? 0 : 1;
     }
 
     else if(command == "decompress")
@@ -51,16 +69,50 @@ int main(int argc, char* argv[])
         }
         string inputFile = argv[2];
         string outputFile = argv[3];
-        
-        decompress(inputFile,outputFile);
 
+        return decompress(inputFile,outputFile) ? 0 : 1;
+    }
+
+    else if(command == "daemon")
+    {
+        if(argc < 3)
+        {
+            cout<<"Missing socket path";
+            return 1;
+        }
+        DaemonOptions options;
+        options.socketPath = argv[2];
+        for(int i = 3; i < argc; i++)
+        {
+            string option = argv[i];
+            if(option == "--workers" && i + 1 < argc)
+                options.workers = atoi(argv[++i]);
+            else if(option == "--batch" && i + 1 < argc)
+                options.batchSize = static_cast<size_t>(atoi(argv[++i]));
+            else
+            {
+                cout<<"Unknown option: "<<option<<"\n";
+                return 1;
+            }
+        }
+        return runDaemon(options);
+    }
+
+    else if(command == "client")
+    {
+        if(argc < 4)
+        {
+            cout<<"Missing socket path or request";
+            return 1;
+        }
+        return runClient(argv[2],vector<string>(argv + 3,argv + argc));
     }
 
     else
     {
         cout<<"Unknown command: "<<command<<"\n";
-        cout<<"Use compress or decompress .\n";
+        cout<<"Use compress, decompress, daemon or client.\n";
     }
 
-    return 0;
+    return 1;
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include "../include/RFLCompress.h"
+#include "../include/rleFormats.h"
+#include "../include/simdKernels.h"
+
+// ============================================================================
+// PERFORMANCE BENCHMARKING
+// ============================================================================
+
+void benchmark_compression(const std::vector<uint8_t>& data, int num_threads) {
+    std::cout << "\n=== RLE Compression Benchmark ===" << std::endl;
+    std::cout << "Input size: " << data.size() << " bytes" << std::endl;
+    std::cout << "Threads: " << num_threads << std::endl;
+    
+    // Sequential compression
+    auto start = std::chrono::high_resolution_clock::now();
+    auto compressed_seq = rle_compress_sequential(data);
+    auto end = std::chrono::high_resolution_clock::now();
+    double time_seq = std::chrono::duration<double>(end - start).count();
+    
+    std::cout << "\nSequential:" << std::endl;
+    std::cout << "  Time: " << time_seq << " seconds" << std::endl;
+    std::cout << "  Output size: " << compressed_seq.size() << " bytes" << std::endl;
+    std::cout << "  Compression ratio: " << 
+        (double)data.size() / compressed_seq.size() << std::endl;
+    
+    // Parallel compression
+    start = std::chrono::high_resolution_clock::now();
+    auto compressed_par = rle_compress_parallel(data, num_threads);
+    end = std::chrono::high_resolution_clock::now();
+    double time_par = std::chrono::duration<double>(end - start).count();
+    
+    std::cout << "\nParallel (" << num_threads << " threads):" << std::endl;
+    std::cout << "  Time: " << time_par << " seconds" << std::endl;
+    std::cout << "  Output size: " << compressed_par.size() << " bytes" << std::endl;
+    std::cout << "  Speedup: " << time_seq / time_par << "x" << std::endl;
+    std::cout << "  Efficiency: " << 
+        (time_seq / time_par) / num_threads * 100 << "%" << std::endl;
+}
+
+void benchmark_decompression(const std::vector<uint8_t>& compressed, int num_threads) {
+    std::cout << "\n=== RLE Decompression Benchmark ===" << std::endl;
+    std::cout << "Compressed size: " << compressed.size() << " bytes" << std::endl;
+    
+    // Sequential decompression
+    auto start = std::chrono::high_resolution_clock::now();
+    auto decompressed_seq = rle_decompress_sequential(compressed);
+    auto end = std::chrono::high_resolution_clock::now();
+    double time_seq = std::chrono::duration<double>(end - start).count();
+    
+    std::cout << "\nSequential:" << std::endl;
+    std::cout << "  Time: " << time_seq << " seconds" << std::endl;
+    std::cout << "  Output size: " << decompressed_seq.size() << " bytes" << std::endl;
+    
+    // Parallel decompression
+    start = std::chrono::high_resolution_clock::now();
+    auto decompressed_par = rle_decompress_parallel(compressed, num_threads);
+    end = std::chrono::high_resolution_clock::now();
+    double time_par = std::chrono::duration<double>(end - start).count();
+    
+    std::cout << "\nParallel (" << num_threads << " threads):" << std::endl;
+    std::cout << "  Time: " << time_par << " seconds" << std::endl;
+    std::cout << "  Speedup: " << time_seq / time_par << "x" << std::endl;
+    std::cout << "  Efficiency: " << 
+        (time_seq / time_par) / num_threads * 100 << "%" << std::endl;
+}
+
+/**
+ * Compares every stream format variant on the same input and checks
+ * that the header-driven decoder reproduces it
+ */
+void benchmark_variants(const std::vector<uint8_t>& data, const std::string& label) {
+    std::cout << "\n=== RLE Format Variants (" << label << ") ===" << std::endl;
+    std::cout << "Input size: " << data.size() << " bytes" << std::endl;
+    
+    for (int v = 0; v < RLE_VARIANT_COUNT; v++) {
+        RleVariant variant = static_cast<RleVariant>(v);
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        auto encoded = rle_encode_stream(variant, data.data(), data.size());
+        auto end = std::chrono::high_resolution_clock::now();
+        double time_enc = std::chrono::duration<double>(end - start).count();
+        
+        std::vector<uint8_t> decoded;
+        start = std::chrono::high_resolution_clock::now();
+        bool ok = rle_decode_stream(encoded.data(), encoded.size(), decoded);
+        end = std::chrono::high_resolution_clock::now();
+        double time_dec = std::chrono::duration<double>(end - start).count();
+        
+        std::cout << "  " << rle_variant_name(variant) << ": "
+                  << encoded.size() << " bytes, ratio "
+                  << (double)data.size() / encoded.size()
+                  << ", encode " << time_enc << " s, decode " << time_dec << " s"
+                  << ((ok && decoded == data) ? "" : "  ROUNDTRIP FAILED") << std::endl;
+    }
+}
+
+// ============================================================================
+// MAIN FUNCTION
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+    std::cout << "RLE Compression/Decompression with OpenMP" << std::endl;
+    std::cout << "==========================================\n" << std::endl;
+    std::cout << "Kernels: " << kernels().isa << std::endl;
+    
+    // Generate test data with repetitive patterns (good for RLE)
+    const size_t data_size = 10 * 1024 * 1024; // 10 MB
+    std::vector<uint8_t> test_data(data_size);
+    
+    // Create data with runs of repeated values
+    for (size_t i = 0; i < data_size; i++) {
+        test_data[i] = static_cast<uint8_t>((i / 100) % 256);
+    }
+    
+    std::cout << "Generated " << data_size << " bytes of test data" << std::endl;
+    
+    // Test different thread counts
+    std::vector<int> thread_counts = {1, 2, 4, 8};
+    
+    for (int num_threads : thread_counts) {
+        std::cout << "\n" << std::string(50, '=') << std::endl;
+        
+        // Benchmark compression
+        benchmark_compression(test_data, num_threads);
+        
+        // Create compressed data for decompression test
+        auto compressed = rle_compress_sequential(test_data);
+        
+        // Benchmark decompression
+        benchmark_decompression(compressed, num_threads);
+    }
+    
+    // Compare stream format variants: long runs, and a 16-bit sensor-style
+    // signal with slowly changing plateaus and noisy stretches
+    benchmark_variants(test_data, "byte runs");
+    
+    std::vector<uint8_t> sensor_data(data_size);
+    for (size_t i = 0; i < data_size / 2; i++) {
+        uint16_t sample = static_cast<uint16_t>(1000 + (i / 5000) % 64);
+        if ((i / 20000) % 4 == 3) sample = static_cast<uint16_t>(sample + (i * 2654435761u >> 20) % 16);
+        sensor_data[2 * i] = static_cast<uint8_t>(sample);
+        sensor_data[2 * i + 1] = static_cast<uint8_t>(sample >> 8);
+    }
+    benchmark_variants(sensor_data, "u16 sensor samples");
+    
+    // Demonstrate pipeline parallelism
+    std::cout << "\n" << std::string(50, '=') << std::endl;
+    std::cout << "\n=== Pipeline Parallelism Demo ===" << std::endl;
+    
+    // Save test data to file
+    std::ofstream test_file("test_input.dat", std::ios::binary);
+    test_file.write(reinterpret_cast<const char*>(test_data.data()), test_data.size());
+    test_file.close();
+    
+    // Run pipeline compression
+    CompressionPipeline pipeline;
+    pipeline.compress_pipeline("test_input.dat", "test_output.rle", 1024 * 1024);
+    
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "../include/rleFormats.h"
+#include <new>
+
+// ============================================================================
+// RUNTIME DISPATCH
+// ============================================================================
+// The only switch on the variant; everything below it is a fixed kernel.
+
+const char* rle_variant_name(RleVariant variant) {
+    switch (variant) {
+        case RleVariant::Pair8:        return "pair8";
+        case RleVariant::PairCount16:  return "pair-count16";
+        case RleVariant::PairVarint:   return "pair-varint";
+        case RleVariant::PairVarint16: return "pair-varint-u16";
+        case RleVariant::PairVarint32: return "pair-varint-u32";
+        case RleVariant::PackBits8:    return "packbits";
+        case RleVariant::PackBits16:   return "packbits-u16";
+        case RleVariant::PackBits32:   return "packbits-u32";
+    }
+    return "unknown";
+}
+
+std::vector<uint8_t> rle_encode_stream(RleVariant variant, const uint8_t* input, size_t size) {
+    switch (variant) {
+        case RleVariant::Pair8:        return rle::encode<RleVariant::Pair8>(input, size);
+        case RleVariant::PairCount16:  return rle::encode<RleVariant::PairCount16>(input, size);
+        case RleVariant::PairVarint:   return rle::encode<RleVariant::PairVarint>(input, size);
+        case RleVariant::PairVarint16: return rle::encode<RleVariant::PairVarint16>(input, size);
+        case RleVariant::PairVarint32: return rle::encode<RleVariant::PairVarint32>(input, size);
+        case RleVariant::PackBits8:    return rle::encode<RleVariant::PackBits8>(input, size);
+        case RleVariant::PackBits16:   return rle::encode<RleVariant::PackBits16>(input, size);
+        case RleVariant::PackBits32:   return rle::encode<RleVariant::PackBits32>(input, size);
+    }
+    return std::vector<uint8_t>();
+}
+
+bool rle_decode_stream(const uint8_t* input, size_t size, std::vector<uint8_t>& output) {
+    output.clear();
+    if (size < RLE_HEADER_SIZE || input[0] != 'R' || input[1] != 'L' || input[2] != 'E') {
+        return false;
+    }
+    uint64_t original = rle::load<uint64_t>(input + 4);
+    const uint8_t* payload = input + RLE_HEADER_SIZE;
+    const uint8_t* end = input + size;
+    size_t n = static_cast<size_t>(original);
+
+    // A single varint run can still claim more memory than exists
+    try {
+        switch (static_cast<RleVariant>(input[3])) {
+            case RleVariant::Pair8:        return rle::decode<RleVariant::Pair8>(payload, end, n, output);
+            case RleVariant::PairCount16:  return rle::decode<RleVariant::PairCount16>(payload, end, n, output);
+            case RleVariant::PairVarint:   return rle::decode<RleVariant::PairVarint>(payload, end, n, output);
+            case RleVariant::PairVarint16: return rle::decode<RleVariant::PairVarint16>(payload, end, n, output);
+            case RleVariant::PairVarint32: return rle::decode<RleVariant::PairVarint32>(payload, end, n, output);
+            case RleVariant::PackBits8:    return rle::decode<RleVariant::PackBits8>(payload, end, n, output);
+            case RleVariant::PackBits16:   return rle::decode<RleVariant::PackBits16>(payload, end, n, output);
+            case RleVariant::PackBits32:   return rle::decode<RleVariant::PackBits32>(payload, end, n, output);
+        }
+    } catch (const std::bad_alloc&) {
+        output.clear();
+    }
+    return false;
+}
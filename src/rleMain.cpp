@@ -0,0 +1,134 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/RFLCompress.h"
+#include "../include/rleFormats.h"
+#include "../include/asyncIO.h"
+#include "../include/dedup.h"
+using namespace std;
+
+static bool parseVariant(const string& name, RleVariant& variant)
+{
+    for (int v = 0; v < RLE_VARIANT_COUNT; v++)
+    {
+        if (name == rle_variant_name(static_cast<RleVariant>(v)))
+        {
+            variant = static_cast<RleVariant>(v);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool writeFile(const string& path, const vector<uint8_t>& data)
+{
+    AsyncFileWriter out(path);
+    if (!out.isOpen()) return false;
+    out.write(data.data(), data.size());
+    return out.close();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        cout<<"Usage: \n";
+        cout<<" compress <input_file> <output_file> [variant] [--dedup]\n";
+        cout<<" decompress <input_file> <output_file>\n";
+        cout<<" pipeline <input_file> <output_file>\n";
+        cout<<"Variants:";
+        for (int v = 0; v < RLE_VARIANT_COUNT; v++)
+            cout<<" "<<rle_variant_name(static_cast<RleVariant>(v));
+        cout<<"\n";
+        return 1;
+    }
+
+    string command = argv[1];
+    string inputFile = argv[2];
+    string outputFile = argv[3];
+
+    if (command == "pipeline")
+    {
+        CompressionPipeline pipeline;
+        return pipeline.compress_pipeline(inputFile, outputFile) ? 0 : 1;
+    }
+
+    string contents;
+    if (!readFileAsync(inputFile, contents))
+    {
+        cerr<<"Error opening the file: "<<inputFile<<endl;
+        return 1;
+    }
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(contents.data());
+
+    vector<uint8_t> result;
+    if (command == "compress")
+    {
+        RleVariant variant = RleVariant::PackBits8;
+        bool dedup = false;
+        for (int i = 4; i < argc; i++)
+        {
+            string option = argv[i];
+            if (option == "--dedup")
+                dedup = true;
+            else if (!parseVariant(option, variant))
+            {
+                cerr<<"Unknown variant: "<<option<<endl;
+                return 1;
+            }
+        }
+        if (dedup)
+        {
+            // Only the unique chunks are run-length coded
+            DedupStats stats;
+            result = dedup_encode_stream(data, contents.size(),
+                [variant](const uint8_t* unique, size_t size) {
+                    return rle_encode_stream(variant, unique, size);
+                },
+                DedupParams(), &stats);
+            cout<<"Chunks: "<<stats.chunks<<" ("<<stats.uniqueChunks<<" unique), "
+                <<stats.duplicateBytes<<" duplicate bytes stored as references\n";
+        }
+        else
+        {
+            result = rle_encode_stream(variant, data, contents.size());
+        }
+        cout<<"Compressed "<<contents.size()<<" bytes to "<<result.size()
+            <<" bytes ("<<rle_variant_name(variant)<<(dedup ? ", dedup" : "")<<")\n";
+    }
+    else if (command == "decompress")
+    {
+        bool ok;
+        if (dedup_is_stream(data, contents.size()))
+        {
+            ok = dedup_decode_stream(data, contents.size(),
+                [](const uint8_t* payload, size_t size, size_t, vector<uint8_t>& unique) {
+                    return rle_decode_stream(payload, size, unique);
+                },
+                result);
+        }
+        else
+        {
+            ok = rle_decode_stream(data, contents.size(), result);
+        }
+        if (!ok)
+        {
+            cerr<<"Error: "<<inputFile<<" is not a valid RLE stream"<<endl;
+            return 1;
+        }
+        cout<<"Decompressed "<<contents.size()<<" bytes to "<<result.size()<<" bytes\n";
+    }
+    else
+    {
+        cout<<"Unknown command: "<<command<<"\n";
+        cout<<"Use compress, decompress or pipeline .\n";
+        return 1;
+    }
+
+    if (!writeFile(outputFile, result))
+    {
+        cerr<<"Error in creating/writing the file "<<outputFile<<endl;
+        return 1;
+    }
+    return 0;
+}
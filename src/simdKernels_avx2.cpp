@@ -0,0 +1,12 @@
+// AVX2 build of the shared kernels (compiled with -mavx2 -mbmi -mbmi2)
+#include "../include/simdKernels.h"
+#if defined(__AVX2__) && defined(__BMI2__)
+#define KERNEL_NS kernels_avx2
+#define KERNEL_LEVEL 2
+#define KERNEL_ISA "avx2"
+#include "simdKernels.inc"
+
+const KernelTable* const kernelsAvx2 = &kernels_avx2::table;
+#else
+const KernelTable* const kernelsAvx2 = nullptr;
+#endif
@@ -0,0 +1,12 @@
+// AVX-512 build of the shared kernels (compiled with -mavx512f -mavx512bw -mavx512vl)
+#include "../include/simdKernels.h"
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__BMI2__)
+#define KERNEL_NS kernels_avx512
+#define KERNEL_LEVEL 3
+#define KERNEL_ISA "avx512"
+#include "simdKernels.inc"
+
+const KernelTable* const kernelsAvx512 = &kernels_avx512::table;
+#else
+const KernelTable* const kernelsAvx512 = nullptr;
+#endif
@@ -0,0 +1,8 @@
+// Portable build of the shared kernels; always available
+#include "../include/simdKernels.h"
+#define KERNEL_NS kernels_scalar
+#define KERNEL_LEVEL 0
+#define KERNEL_ISA "scalar"
+#include "simdKernels.inc"
+
+const KernelTable* const kernelsScalar = &kernels_scalar::table;
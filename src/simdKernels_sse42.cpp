@@ -0,0 +1,12 @@
+// SSE4.2 build of the shared kernels (compiled with -msse4.2 -mpopcnt)
+#include "../include/simdKernels.h"
+#if defined(__SSE4_2__)
+#define KERNEL_NS kernels_sse42
+#define KERNEL_LEVEL 1
+#define KERNEL_ISA "sse4.2"
+#include "simdKernels.inc"
+
+const KernelTable* const kernelsSse42 = &kernels_sse42::table;
+#else
+const KernelTable* const kernelsSse42 = nullptr;
+#endif
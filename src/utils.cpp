@@ -1,13 +1,28 @@
 #include "../include/utils.h"
+#include "../include/simdKernels.h"
+#include <algorithm>
 #include <map>
+#include <omp.h>
 
-std::map<char, int> calculateFrequencies(const std::string& text) {
+std::map<char, int> calculateFrequencies(const std::string& text, int numThreads) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+    const size_t chunk = 1024 * 1024;
+    const long chunks = static_cast<long>((text.size() + chunk - 1) / chunk);
+    uint64_t counts[256] = {};
+    if (numThreads <= 0) numThreads = omp_get_max_threads();
+
+    // Per-chunk histograms in parallel, merged once per chunk
+    #pragma omp parallel for num_threads(numThreads) schedule(static) if(chunks > 1 && numThreads > 1)
+    for (long c = 0; c < chunks; c++) {
+        uint64_t local[256] = {};
+        size_t begin = static_cast<size_t>(c) * chunk;
+        kernels().histogram(data + begin, std::min(chunk, text.size() - begin), local);
+        #pragma omp critical (histogram_merge)
+        for (int b = 0; b < 256; b++) counts[b] += local[b];
+    }
     std::map<char, int> freq;
-    for (char c : text) {
-        freq[c]++;
+    for (int b = 0; b < 256; b++) {
+        if (counts[b]) freq[static_cast<char>(b)] = static_cast<int>(counts[b]);
     }
     return freq;
 }
-
-
-
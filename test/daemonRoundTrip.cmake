@@ -0,0 +1,99 @@
+# Starts TOOL as a daemon on a temporary socket and sends one batch through
+# the client: compress and decompress of INPUT, with and without --dedup,
+# then stats. The --dedup result must match INPUT; the plain files must match
+# what the CLI writes for the same input. Sends shutdown at the end.
+#
+#   cmake -DTOOL=<exe> -DINPUT=<file> -DOUTPUT=<prefix> -P daemonRoundTrip.cmake
+
+set(socket "${OUTPUT}.sock")
+file(REMOVE "${socket}")
+
+# The daemon's output goes to a log so execute_process doesn't wait on it
+execute_process(COMMAND sh -c "\"$0\" daemon \"$1\" --workers 2 >\"$2\" 2>&1 &"
+                        "${TOOL}" "${socket}" "${OUTPUT}.log"
+                RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "cannot start the daemon (${rc})")
+endif()
+foreach(attempt RANGE 50)
+    if(EXISTS "${socket}")
+        break()
+    endif()
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E sleep 0.1)
+endforeach()
+if(NOT EXISTS "${socket}")
+    message(FATAL_ERROR "daemon did not create ${socket}")
+endif()
+
+macro(stop_daemon)
+    execute_process(COMMAND "${TOOL}" client "${socket}" shutdown
+                    RESULT_VARIABLE stop_rc OUTPUT_VARIABLE stop_reply)
+endmacro()
+
+macro(fail message)
+    stop_daemon()
+    message(FATAL_ERROR "${message}")
+endmacro()
+
+file(WRITE "${OUTPUT}.requests"
+     "compress ${INPUT} ${OUTPUT}.plain\n"
+     "decompress ${OUTPUT}.plain ${OUTPUT}.plain.restored\n"
+     "compress ${INPUT} ${OUTPUT}.dedup --dedup\n"
+     "decompress ${OUTPUT}.dedup ${OUTPUT}.dedup.restored\n"
+     "stats\n")
+execute_process(COMMAND "${TOOL}" client "${socket}" -
+                INPUT_FILE "${OUTPUT}.requests"
+                RESULT_VARIABLE rc OUTPUT_VARIABLE replies)
+if(NOT rc EQUAL 0)
+    fail("client batch failed (${rc}): ${replies}")
+endif()
+string(REGEX MATCHALL "[^\n]+" lines "${replies}")
+list(LENGTH lines count)
+if(NOT count EQUAL 5)
+    fail("expected 5 replies, got: ${replies}")
+endif()
+foreach(line IN LISTS lines)
+    if(NOT line MATCHES "^ok ")
+        fail("request failed: ${line}")
+    endif()
+endforeach()
+# stats runs after the four requests before it in the batch
+list(GET lines 4 stats)
+if(NOT stats MATCHES "queue_depth=0 " OR NOT stats MATCHES " completed=4 ")
+    fail("unexpected stats: ${stats}")
+endif()
+
+execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${INPUT}" "${OUTPUT}.dedup.restored"
+                RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    fail("${OUTPUT}.dedup.restored differs from ${INPUT}")
+endif()
+
+execute_process(COMMAND "${TOOL}" compress "${INPUT}" "${OUTPUT}.cli" RESULT_VARIABLE rc OUTPUT_QUIET)
+execute_process(COMMAND "${TOOL}" decompress "${OUTPUT}.cli" "${OUTPUT}.cli.restored"
+                RESULT_VARIABLE rc2 OUTPUT_QUIET)
+if(NOT rc EQUAL 0 OR NOT rc2 EQUAL 0)
+    fail("CLI compress/decompress failed on ${INPUT}")
+endif()
+foreach(suffix "" .map .restored)
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files
+                            "${OUTPUT}.cli${suffix}" "${OUTPUT}.plain${suffix}"
+                    RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        fail("${OUTPUT}.plain${suffix} differs from the CLI output")
+    endif()
+endforeach()
+
+stop_daemon()
+if(NOT stop_rc EQUAL 0 OR NOT stop_reply MATCHES "^ok shutting down")
+    message(FATAL_ERROR "shutdown failed (${stop_rc}): ${stop_reply}")
+endif()
+foreach(attempt RANGE 50)
+    if(NOT EXISTS "${socket}")
+        break()
+    endif()
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E sleep 0.1)
+endforeach()
+if(EXISTS "${socket}")
+    message(FATAL_ERROR "daemon did not exit after shutdown")
+endif()
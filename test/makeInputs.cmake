@@ -0,0 +1,35 @@
+# Generates the ctest inputs in WORK from the sample text in SOURCE:
+#   large.txt    over 1 MB, so compress takes the parallel encoder
+#   runs.txt     long runs and an odd length, for the wide RLE variants
+#   repeats.txt  repeated blocks with small edits between, for dedup
+#   single.txt   one distinct byte, for dedup's 1-bit code
+#
+#   cmake -DSOURCE=<file> -DWORK=<dir> -P makeInputs.cmake
+
+file(READ "${SOURCE}" sample)
+file(MAKE_DIRECTORY "${WORK}")
+
+set(large "")
+foreach(i RANGE 1 700)
+    string(APPEND large "${sample}line ${i}\n")
+endforeach()
+file(WRITE "${WORK}/large.txt" "${large}")
+
+set(runs "")
+foreach(i RANGE 1 400)
+    math(EXPR pick "${i} % 3")
+    string(SUBSTRING "abc" ${pick} 1 symbol)
+    string(REPEAT "${symbol}" ${i} run)
+    string(APPEND runs "${run}")
+endforeach()
+file(WRITE "${WORK}/runs.txt" "${runs}z")
+
+string(REPEAT "${sample}" 8 block)
+set(repeats "")
+foreach(i RANGE 1 12)
+    string(APPEND repeats "${block}edit ${i}\n")
+endforeach()
+file(WRITE "${WORK}/repeats.txt" "${repeats}")
+
+string(REPEAT "a" 100000 single)
+file(WRITE "${WORK}/single.txt" "${single}")
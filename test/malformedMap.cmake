@@ -0,0 +1,17 @@
+# A token map whose code lengths break the Kraft inequality must be
+# rejected, not decoded: every one-bit code past the first two would land
+# outside the decode table.
+#
+#   cmake -DTOOL=<exe> -DOUTPUT=<prefix> -P malformedMap.cmake
+
+get_filename_component(dir "${OUTPUT}" DIRECTORY)
+file(MAKE_DIRECTORY "${dir}")
+string(REPEAT "61 1\n" 200000 codes)
+file(WRITE "${OUTPUT}.packed.map" "#huffman-tokens words 1 200000\n${codes}")
+file(WRITE "${OUTPUT}.packed" "x")
+
+execute_process(COMMAND "${TOOL}" decompress "${OUTPUT}.packed" "${OUTPUT}.restored"
+                RESULT_VARIABLE rc OUTPUT_QUIET ERROR_VARIABLE err)
+if(NOT rc STREQUAL "1" OR NOT err MATCHES "malformed token map")
+    message(FATAL_ERROR "decompress accepted a malformed map (${rc}): ${err}")
+endif()
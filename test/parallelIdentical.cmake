@@ -0,0 +1,26 @@
+# The parallel Huffman encoder must write exactly what the serial one does:
+# compresses INPUT with --threads 1 and --threads THREADS and compares the
+# outputs and their map files.
+#
+#   cmake -DTOOL=<exe> -DINPUT=<file> -DOUTPUT=<prefix> -DTHREADS=<n> -P parallelIdentical.cmake
+
+foreach(threads 1 ${THREADS})
+    execute_process(COMMAND "${TOOL}" compress "${INPUT}" "${OUTPUT}.t${threads}" --threads ${threads}
+                    RESULT_VARIABLE rc OUTPUT_VARIABLE log)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "compress --threads ${threads} failed (${rc})")
+    endif()
+    # Make sure the run took the encoder it was meant to
+    if(NOT log MATCHES "\\(${threads} threads?\\)")
+        message(FATAL_ERROR "compress --threads ${threads} did not use ${threads} threads:\n${log}")
+    endif()
+endforeach()
+
+foreach(suffix "" ".map")
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files
+                            "${OUTPUT}.t1${suffix}" "${OUTPUT}.t${THREADS}${suffix}"
+                    RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "--threads ${THREADS} output${suffix} differs from --threads 1")
+    endif()
+endforeach()
@@ -0,0 +1,28 @@
+# Packs INPUT with TOOL, unpacks it again and checks the result is byte for
+# byte the same. PACK is the packing command (default compress) and ARGS any
+# extra arguments for it, space separated.
+#
+#   cmake -DTOOL=<exe> -DINPUT=<file> -DOUTPUT=<prefix> [-DPACK=<cmd>] [-DARGS=<args>] -P roundTrip.cmake
+
+if(NOT PACK)
+    set(PACK compress)
+endif()
+separate_arguments(extra UNIX_COMMAND "${ARGS}")
+
+execute_process(COMMAND "${TOOL}" ${PACK} "${INPUT}" "${OUTPUT}.packed" ${extra}
+                RESULT_VARIABLE rc OUTPUT_QUIET)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "${PACK} ${extra} failed on ${INPUT} (${rc})")
+endif()
+
+execute_process(COMMAND "${TOOL}" decompress "${OUTPUT}.packed" "${OUTPUT}.restored"
+                RESULT_VARIABLE rc OUTPUT_QUIET)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "decompress failed on ${OUTPUT}.packed (${rc})")
+endif()
+
+execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${INPUT}" "${OUTPUT}.restored"
+                RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "${OUTPUT}.restored differs from ${INPUT}")
+endif()